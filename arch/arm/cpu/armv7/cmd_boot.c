@@ -9,11 +9,13 @@
  */
 #include <common.h>
 #include <command.h>
+#include <smp_job.h>
 
 #ifdef CONFIG_CMD_GO
 unsigned long do_go_exec(ulong (*entry)(int, char * const []), int argc,
 				 char * const argv[])
 {
+	smp_job_stop();
 	invalidate_icache_all();
 	return entry(argc, argv);
 }
@@ -18,6 +18,7 @@
 #ifdef CONFIG_SPL_BUILD
 #include <spl.h>
 #endif
+#include <asm/armv7.h>
 #include <asm/gpio.h>
 #include <asm/io.h>
 #include <asm/arch/clock.h>
@@ -101,6 +102,10 @@ void s_init(void)
 		"orr r0, r0, #1 << 6\n"
 		"mcr p15, 0, r0, c1, c0, 1\n");
 #endif
+#if !defined CONFIG_SPL_BUILD && defined CONFIG_SHA_NEON
+	/* sha_neon.c relies on NEON being on */
+	v7_neon_enable();
+#endif
 
 	watchdog_init();
 	clock_init();
@@ -0,0 +1,50 @@
+/*
+ * Per command latency counters of the sunxi MMC driver.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <asm/arch/mmc.h>
+
+static void print_mmc_stats(int sdc_no)
+{
+	const struct sunxi_mmc_cmd_stats *st = sunxi_mmc_get_stats(sdc_no);
+	int i;
+
+	if (!st)
+		return;
+
+	printf("mmc%d:\n", sdc_no);
+	printf("  cmd    count  errors   avg(us)   max(us)\n");
+	for (i = 0; i < SUNXI_MMC_STATS_CMDS; i++) {
+		if (!st[i].count)
+			continue;
+		printf("  %3d %8lu %7lu %9lu %9lu\n", i, st[i].count,
+		       st[i].errors, st[i].total_us / st[i].count,
+		       st[i].max_us);
+	}
+}
+
+static int do_sunxi_mmc_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			      char * const argv[])
+{
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (argc > 1 && !strcmp(argv[1], "reset"))
+			sunxi_mmc_reset_stats(i);
+		else
+			print_mmc_stats(i);
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	mmcstat, 2, 1, do_sunxi_mmc_stats,
+	"show sunxi mmc per command latency",
+	"       - print count, average and worst case latency per command\n"
+	"mmcstat reset - clear the counters"
+);
@@ -6,7 +6,12 @@
  */
 
 #include <common.h>
+#include <errno.h>
+#include <smp_job.h>
+#include <watchdog.h>
+#include <asm/armv7.h>
 #include <asm/io.h>
+#include <asm/system.h>
 #include <asm/arch/smp.h>
 #include <asm/arch/cpucfg.h>
 
@@ -41,6 +46,35 @@ void secondary_start(void)
 	secondary_pen();
 }
 
+static void power_on_secondary(struct sunxi_cpucfg *cpucfg, int i)
+{
+	u32 j;
+
+	/* Assert CPU reset just in case */
+	writel(CPU_RESET_SET, &cpucfg->cpu[i].reset_ctrl);
+	/* Ensure CPU reset also invalidates L1 caches */
+	clrbits_le32(&cpucfg->general_ctrl, GENERAL_CTRL_NO_L1_RESET_CPU(i));
+	/* Lock CPU */
+	clrbits_le32(&cpucfg->debug1_ctrl, 1 << i);
+
+	/* Ramp up power to CPU1 */
+	assert(i == 1);
+	j = 0xff << 1;
+	do {
+		j = j >> 1;
+		writel(j, &cpucfg->cpu1_power_clamp);
+	} while (j != 0);
+
+	udelay(10*1000); /* 10ms */
+
+	clrbits_le32(&cpucfg->cpu1_power_off, 1);
+	/* Release CPU reset */
+	writel(CPU_RESET_CLEAR, &cpucfg->cpu[i].reset_ctrl);
+
+	/* Unlock CPU */
+	setbits_le32(&cpucfg->debug1_ctrl, 1 << i);
+}
+
 /* Power on secondaries */
 void startup_secondaries(void)
 {
@@ -50,31 +84,232 @@ void startup_secondaries(void)
 	writel((u32)secondary_init, &cpucfg->boot_addr);
 
 	for (i = 1; i < NUM_CORES; i++) {
-		/* Assert CPU reset just in case */
-		writel(CPU_RESET_SET, &cpucfg->cpu[i].reset_ctrl);
-		/* Ensure CPU reset also invalidates L1 caches */
-		clrbits_le32(&cpucfg->general_ctrl,
-				GENERAL_CTRL_NO_L1_RESET_CPU(i));
-		/* Lock CPU */
-		clrbits_le32(&cpucfg->debug1_ctrl, 1 << i);
-
-		/* Ramp up power to CPU1 */
-		assert(i == 1);
-		u32 j = 0xff << 1;
-		do {
-			j = j >> 1;
-			writel(j, &cpucfg->cpu1_power_clamp);
-		} while (j != 0);
-
-		udelay(10*1000); /* 10ms */
-
-		clrbits_le32(&cpucfg->cpu1_power_off, 1);
-		/* Release CPU reset */
-		writel(CPU_RESET_CLEAR, &cpucfg->cpu[i].reset_ctrl);
-
-		/* Unlock CPU */
-		setbits_le32(&cpucfg->debug1_ctrl, 1 << i);
-
+		power_on_secondary(cpucfg, i);
 		printf("Secondary CPU%d power-on\n", i);
 	}
 }
+
+#ifdef CONFIG_SMP_JOBS
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * Jobs run on CPU1 only. The two cores do not snoop each other here
+ * (U-Boot maps RAM non-shareable), so every hand over goes through
+ * memory: the mailbox sits in a cache line of its own and both sides
+ * clean or invalidate it around each access.
+ */
+#define SMP_JOB_CPU		1
+#define SMP_JOB_START_TIMEOUT	100	/* ms for CPU1 to pick up a job */
+
+enum {
+	SMP_JOB_IDLE,
+	SMP_JOB_PENDING,
+	SMP_JOB_RUNNING,
+	SMP_JOB_DONE,
+};
+
+struct smp_mailbox {
+	smp_job_func func;
+	void *arg;
+	const void *in;
+	size_t in_len;
+	void *out;
+	size_t out_len;
+	u32 ttbr;		/* page table to run with, 0 for no MMU */
+	volatile u32 state;
+} __aligned(ARCH_DMA_MINALIGN);
+
+static struct smp_mailbox smp_mbox;
+static int smp_job_cpu_on;	/* CPU1 is running smp_job_loop() */
+static int smp_job_queued;	/* boot CPU view: a job is outstanding */
+
+/*
+ * CPU1's stack and global data take whole cache lines of their own: a
+ * line shared with data of the boot CPU would undo the other core's
+ * writes whenever either core writes it back or drops it.
+ */
+u32 smp_job_stack[ALIGN(SMP_JOB_STACK_SIZE, ARCH_DMA_MINALIGN) / sizeof(u32)]
+	__aligned(ARCH_DMA_MINALIGN);
+
+struct smp_job_gd {
+	gd_t gd;
+} __aligned(ARCH_DMA_MINALIGN);
+
+struct smp_job_gd smp_job_gd;
+
+static void smp_mbox_flush(void)
+{
+	flush_dcache_range((ulong)&smp_mbox, (ulong)(&smp_mbox + 1));
+}
+
+static void smp_mbox_invalidate(void)
+{
+	invalidate_dcache_range((ulong)&smp_mbox, (ulong)(&smp_mbox + 1));
+}
+
+static void smp_job_region_flush(const void *p, size_t len)
+{
+	if (p && len)
+		flush_dcache_range((ulong)p, (ulong)p + len);
+}
+
+/* Give CPU1 the same memory view as the boot CPU */
+static void smp_job_enable_caches(u32 ttbr)
+{
+	u32 reg;
+
+	/* ACTLR.SMP, as s_init() does for CPU0 */
+	__asm__ __volatile__("mrc p15, 0, %0, c1, c0, 1" : "=r" (reg));
+	reg |= 1 << 6;
+	__asm__ __volatile__("mcr p15, 0, %0, c1, c0, 1" : : "r" (reg));
+#ifdef CONFIG_SHA_NEON
+	/* as s_init() does too, for the NEON hash code */
+	v7_neon_enable();
+#endif
+
+	if (ttbr) {
+		/* TLBIALL, then the boot CPU's tables with all domains manager */
+		__asm__ __volatile__("mcr p15, 0, %0, c8, c7, 0" : : "r" (0));
+		__asm__ __volatile__("mcr p15, 0, %0, c2, c0, 0"
+				     : : "r" (ttbr) : "memory");
+		__asm__ __volatile__("mcr p15, 0, %0, c3, c0, 0"
+				     : : "r" (~0));
+		__asm__ __volatile__("dsb\n\tisb" ::: "memory");
+		set_cr(get_cr() | CR_M | CR_C | CR_I);
+	} else {
+		set_cr(get_cr() | CR_I);
+	}
+}
+
+/* Runs on CPU1, entered from smp_job_entry with sp and gd set up */
+void smp_job_loop(void)
+{
+	smp_job_enable_caches(smp_mbox.ttbr);
+
+	while (1) {
+		smp_mbox_invalidate();
+		if (smp_mbox.state == SMP_JOB_PENDING) {
+			smp_mbox.state = SMP_JOB_RUNNING;
+			smp_mbox_flush();
+
+			/* drop anything stale from an earlier job */
+			smp_job_region_flush(smp_mbox.in, smp_mbox.in_len);
+			smp_job_region_flush(smp_mbox.out, smp_mbox.out_len);
+			smp_mbox.func(smp_mbox.arg);
+			smp_job_region_flush(smp_mbox.out, smp_mbox.out_len);
+
+			smp_mbox.state = SMP_JOB_DONE;
+			smp_mbox_flush();
+			__asm__ __volatile__("dsb\n\tsev" ::: "memory");
+			continue;
+		}
+		__asm__ __volatile__("wfe" ::: "memory");
+	}
+}
+
+static void smp_job_cpu_off(void)
+{
+	struct sunxi_cpucfg *cpucfg = (struct sunxi_cpucfg *)SUNXI_CPUCFG_BASE;
+
+	writel(CPU_RESET_SET, &cpucfg->cpu[SMP_JOB_CPU].reset_ctrl);
+	writel(0xff, &cpucfg->cpu1_power_clamp);
+	setbits_le32(&cpucfg->cpu1_power_off, 1);
+	smp_job_cpu_on = 0;
+}
+
+int smp_job_submit(smp_job_func func, void *arg, const void *in,
+		   size_t in_len, void *out, size_t out_len)
+{
+	struct sunxi_cpucfg *cpucfg = (struct sunxi_cpucfg *)SUNXI_CPUCFG_BASE;
+
+	if (smp_job_queued)
+		return -EBUSY;
+
+	smp_mbox.func = func;
+	smp_mbox.arg = arg;
+	smp_mbox.in = in;
+	smp_mbox.in_len = in_len;
+	smp_mbox.out = out;
+	smp_mbox.out_len = out_len;
+	smp_mbox.ttbr = dcache_status() ? gd->arch.tlb_addr : 0;
+	smp_mbox.state = SMP_JOB_PENDING;
+
+	smp_job_region_flush(in, in_len);
+	smp_job_region_flush(out, out_len);
+	smp_mbox_flush();
+	smp_job_queued = 1;
+
+	if (!smp_job_cpu_on) {
+		/* start CPU1 straight into the job loop, with its own gd */
+		memcpy(&smp_job_gd.gd, (void *)gd, sizeof(gd_t));
+		flush_dcache_range((ulong)&smp_job_gd,
+				   (ulong)(&smp_job_gd + 1));
+		writel((u32)smp_job_entry, &cpucfg->boot_addr);
+		power_on_secondary(cpucfg, SMP_JOB_CPU);
+		smp_job_cpu_on = 1;
+	} else {
+		__asm__ __volatile__("dsb\n\tsev" ::: "memory");
+	}
+
+	return 0;
+}
+
+int smp_job_wait(void)
+{
+	ulong start;
+
+	if (!smp_job_queued)
+		return -ENOENT;
+
+	start = get_timer(0);
+	while (1) {
+		smp_mbox_invalidate();
+		if (smp_mbox.state == SMP_JOB_DONE)
+			break;
+		if (smp_mbox.state == SMP_JOB_PENDING &&
+		    get_timer(start) > SMP_JOB_START_TIMEOUT) {
+			printf("CPU%d not responding, running job on CPU0\n",
+			       SMP_JOB_CPU);
+			smp_job_cpu_off();
+			smp_mbox.func(smp_mbox.arg);
+			goto done;
+		}
+		WATCHDOG_RESET();
+	}
+
+	if (smp_mbox.out && smp_mbox.out_len)
+		invalidate_dcache_range((ulong)smp_mbox.out,
+					(ulong)smp_mbox.out + smp_mbox.out_len);
+done:
+	smp_mbox.state = SMP_JOB_IDLE;
+	smp_job_queued = 0;
+
+	return 0;
+}
+
+void smp_job_stop(void)
+{
+	if (!smp_job_cpu_on)
+		return;
+
+	smp_job_wait();
+#ifdef CONFIG_SYS_SECONDARY_ON
+	/*
+	 * Put CPU1 back into the pen of the U-Boot image the SPL loaded,
+	 * which is where the OS expects to find it.
+	 */
+	struct sunxi_cpucfg *cpucfg = (struct sunxi_cpucfg *)SUNXI_CPUCFG_BASE;
+
+	writel((u32)secondary_init - gd->reloc_off, &cpucfg->boot_addr);
+	power_on_secondary(cpucfg, SMP_JOB_CPU);
+	smp_job_cpu_on = 0;
+#else
+	smp_job_cpu_off();
+#endif
+}
+
+void arch_preboot_os(void)
+{
+	smp_job_stop();
+}
+#endif /* CONFIG_SMP_JOBS */
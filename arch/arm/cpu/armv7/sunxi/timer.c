@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <asm/io.h>
 #include <asm/arch/timer.h>
 
@@ -78,6 +79,21 @@ ulong get_timer_masked(void)
 	return gd->arch.tbl;
 }
 
+/*
+ * Microseconds since timer_init(). The raw counter wraps after ~179 s at
+ * 24 MHz, so the elapsed ticks are accumulated into a 64-bit count;
+ * callers just need to sample more often than that.
+ */
+ulong timer_get_us(void)
+{
+	ulong now = read_timer();
+
+	gd->arch.timer_reset_value += now - gd->arch.tbu;
+	gd->arch.tbu = now;
+
+	return lldiv(gd->arch.timer_reset_value, TIMER_CLOCK / 1000000);
+}
+
 /* delay x useconds */
 void __udelay(unsigned long usec)
 {
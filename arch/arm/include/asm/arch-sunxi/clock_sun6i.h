@@ -186,6 +186,10 @@ struct sunxi_ccm_reg {
 #define AHB_GATE_OFFSET_MMC(n)		(AHB_GATE_OFFSET_MMC0 + (n))
 
 #define CCM_MMC_CTRL_OSCM24 (0x0 << 24)
+#define CCM_MMC_CTRL_M(x)	((x) - 1)
+#define CCM_MMC_CTRL_OCLK_DLY(x) ((x) << 8)
+#define CCM_MMC_CTRL_N(x)	((x) << 16)
+#define CCM_MMC_CTRL_SCLK_DLY(x) ((x) << 20)
 #define CCM_MMC_CTRL_PLL6   (0x1 << 24)
 
 #define CCM_MMC_CTRL_ENABLE (0x1 << 31)
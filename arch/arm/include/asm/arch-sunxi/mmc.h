@@ -55,6 +55,7 @@ struct sunxi_mmc {
 					 SUNXI_MMC_GCTRL_FIFO_RESET|\
 					 SUNXI_MMC_GCTRL_DMA_RESET)
 #define SUNXI_MMC_GCTRL_DMA_ENABLE	(0x1 << 5)
+#define SUNXI_MMC_GCTRL_DDR_MODE	(0x1 << 10)
 #define SUNXI_MMC_GCTRL_ACCESS_BY_AHB   (0x1 << 31)
 
 #define SUNXI_MMC_CMD_RESP_EXPIRE	(0x1 << 6)
@@ -118,5 +119,49 @@ struct sunxi_mmc {
 #define SUNXI_MMC_IDIE_TXIRQ		(0x1 << 0)
 #define SUNXI_MMC_IDIE_RXIRQ		(0x1 << 1)
 
+#define SUNXI_MMC_IDST_TXIRQ		(0x1 << 0)
+#define SUNXI_MMC_IDST_RXIRQ		(0x1 << 1)
+#define SUNXI_MMC_IDST_FATAL_BUS_ERROR	(0x1 << 2)
+#define SUNXI_MMC_IDST_DES_UNAVAILABLE	(0x1 << 4)
+#define SUNXI_MMC_IDST_CARD_ERROR_SUM	(0x1 << 5)
+#define SUNXI_MMC_IDST_ERROR_BIT		\
+	(SUNXI_MMC_IDST_FATAL_BUS_ERROR |	\
+	 SUNXI_MMC_IDST_DES_UNAVAILABLE |	\
+	 SUNXI_MMC_IDST_CARD_ERROR_SUM)
+
+/* burst size 8, RX trigger level 7, TX trigger level 8 */
+#define SUNXI_MMC_FTRGLEVEL_DMA		0x20070008
+
+/* internal DMA descriptor, must be 32-bit aligned, chained mode only */
+struct sunxi_mmc_des {
+	u32 config;
+	u32 buf_size;		/* 13 bits on sun4i/5i/7i, 16 bits on sun6i */
+	u32 buf_addr;
+	u32 next_desc;
+};
+
+#define SUNXI_MMC_DES_DIC		(0x1 << 1) /* no irq on completion */
+#define SUNXI_MMC_DES_LAST		(0x1 << 2)
+#define SUNXI_MMC_DES_FIRST		(0x1 << 3)
+#define SUNXI_MMC_DES_CHAIN		(0x1 << 4)
+#define SUNXI_MMC_DES_END_OF_RING	(0x1 << 5)
+#define SUNXI_MMC_DES_CARD_ERROR	(0x1 << 30)
+#define SUNXI_MMC_DES_OWN		(0x1 << 31)
+
+/* largest buffer size every sunxi generation can describe */
+#define SUNXI_MMC_DES_MAX_LEN		4096
+
+/* per command index latency counters, see CONFIG_MMC_SUNXI_STATS */
+#define SUNXI_MMC_STATS_CMDS		64
+
+struct sunxi_mmc_cmd_stats {
+	unsigned long count;
+	unsigned long errors;
+	unsigned long total_us;
+	unsigned long max_us;
+};
+
 int sunxi_mmc_init(int sdc_no);
+const struct sunxi_mmc_cmd_stats *sunxi_mmc_get_stats(int sdc_no);
+void sunxi_mmc_reset_stats(int sdc_no);
 #endif /* _SUNXI_MMC_H */
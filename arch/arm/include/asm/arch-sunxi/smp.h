@@ -10,12 +10,16 @@
 #ifndef _SUNXI_SMP_H_
 #define _SUNXI_SMP_H_
 
+/* Stack of the secondary while it runs smp_job_submit() jobs */
+#define SMP_JOB_STACK_SIZE	8192
+
 #ifndef __ASSEMBLY__
 
 void startup_secondaries(void);
 
-/* Assembly entry point */
+/* Assembly entry points */
 extern void secondary_init(void);
+extern void smp_job_entry(void);
 
 #endif /* __ASSEMBLY__ */
 
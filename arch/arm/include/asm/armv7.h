@@ -76,6 +76,25 @@ void v7_outer_cache_inval_all(void);
 void v7_outer_cache_flush_range(u32 start, u32 end);
 void v7_outer_cache_inval_range(u32 start, u32 end);
 
+/*
+ * Give this CPU full access to VFP/NEON (cp10, cp11) and set FPEXC.EN.
+ * Call it before any code built with -mfpu=neon runs on the CPU; it must
+ * not be inlined into such code, where the compiler is free to move NEON
+ * instructions ahead of it.
+ */
+static inline void v7_neon_enable(void)
+{
+	u32 cpacr;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	cpacr |= 0xf << 20;
+	asm volatile("mcr p15, 0, %0, c1, c0, 2" : : "r" (cpacr) : "memory");
+	CP15ISB;
+	/* vmsr fpexc, as mcr so the assembler needs no VFP support */
+	asm volatile("mcr p10, 7, %0, cr8, cr0, 0" : : "r" (1 << 30)
+		     : "memory");
+}
+
 #if defined(CONFIG_ARMV7_NONSEC) || defined(CONFIG_ARMV7_VIRT)
 
 int armv7_switch_nonsec(void);
@@ -0,0 +1,257 @@
+/*
+ * SHA-1 and SHA-256 block functions using NEON for the message schedule
+ *
+ * The message schedule is computed four words at a time in NEON registers,
+ * with the round constants already added, while the rounds themselves run
+ * on the integer pipeline reading one precomputed word per round. Loading
+ * the block through vld1.8 and vrev32.8 also replaces the byte-by-byte
+ * big endian loads of the generic code and copes with unaligned input.
+ *
+ * This file is built with -mfpu=neon; it must not include <common.h>, as
+ * <arm_neon.h> brings in the compiler's <stdint.h>. Nothing here switches
+ * NEON on, since the compiler may place NEON instructions ahead of any
+ * such code: the platform calls v7_neon_enable() on every CPU that may
+ * hash (sunxi: s_init() and the second core's job loop).
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <arm_neon.h>
+#include <sha1.h>
+#include <sha256.h>
+#include <sha_neon.h>
+
+#define ROR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define ROL(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Lane-wise rotates; the two halves never overlap so OR does the job */
+#define VROR(x, n)	vorrq_u32(vshrq_n_u32(x, n), vshlq_n_u32(x, 32 - (n)))
+#define VROL(x, n)	vorrq_u32(vshlq_n_u32(x, n), vshrq_n_u32(x, 32 - (n)))
+#define VROR2(x, n)	vorr_u32(vshr_n_u32(x, n), vshl_n_u32(x, 32 - (n)))
+
+static inline uint32x4_t load_be32x4(const unsigned char *p)
+{
+	return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* s0 and s1 of FIPS 180-2, on two or four words at once */
+static inline uint32x4_t sha256_s0(uint32x4_t x)
+{
+	return veorq_u32(veorq_u32(VROR(x, 7), VROR(x, 18)),
+			 vshrq_n_u32(x, 3));
+}
+
+static inline uint32x2_t sha256_s1(uint32x2_t x)
+{
+	return veor_u32(veor_u32(VROR2(x, 17), VROR2(x, 19)),
+			vshr_n_u32(x, 10));
+}
+
+/*
+ * W[i..i+3] from the previous sixteen words in w0..w3. The two upper words
+ * depend on the two lower ones through s1(), so they take a second step.
+ */
+static inline uint32x4_t sha256_schedule(uint32x4_t w0, uint32x4_t w1,
+					 uint32x4_t w2, uint32x4_t w3)
+{
+	uint32x4_t t;
+	uint32x2_t lo, hi;
+
+	t = vaddq_u32(w0, sha256_s0(vextq_u32(w0, w1, 1)));
+	t = vaddq_u32(t, vextq_u32(w2, w3, 1));
+	lo = vadd_u32(vget_low_u32(t), sha256_s1(vget_high_u32(w3)));
+	hi = vadd_u32(vget_high_u32(t), sha256_s1(lo));
+
+	return vcombine_u32(lo, hi);
+}
+
+#define S2(x)		(ROR(x, 2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define S3(x)		(ROR(x, 6) ^ ROR(x, 11) ^ ROR(x, 25))
+#define F0(x, y, z)	((x & y) | (z & (x | y)))
+#define F1(x, y, z)	(z ^ (x & (y ^ z)))
+
+#define P(a, b, c, d, e, f, g, h, wk) {			\
+	temp1 = h + S3(e) + F1(e, f, g) + (wk);		\
+	temp2 = S2(a) + F0(a, b, c);			\
+	d += temp1;					\
+	h = temp1 + temp2;				\
+}
+
+void sha256_neon_block(sha256_context *ctx, const uint8_t data[64])
+{
+	uint32_t wk[64] __attribute__((aligned(16)));
+	uint32_t temp1, temp2;
+	uint32_t A, B, C, D, E, F, G, H;
+	uint32x4_t w0, w1, w2, w3, w;
+	int i;
+
+	w0 = load_be32x4(data);
+	w1 = load_be32x4(data + 16);
+	w2 = load_be32x4(data + 32);
+	w3 = load_be32x4(data + 48);
+	vst1q_u32(wk, vaddq_u32(w0, vld1q_u32(sha256_k)));
+	vst1q_u32(wk + 4, vaddq_u32(w1, vld1q_u32(sha256_k + 4)));
+	vst1q_u32(wk + 8, vaddq_u32(w2, vld1q_u32(sha256_k + 8)));
+	vst1q_u32(wk + 12, vaddq_u32(w3, vld1q_u32(sha256_k + 12)));
+
+	for (i = 16; i < 64; i += 4) {
+		w = sha256_schedule(w0, w1, w2, w3);
+		vst1q_u32(wk + i, vaddq_u32(w, vld1q_u32(sha256_k + i)));
+		w0 = w1;
+		w1 = w2;
+		w2 = w3;
+		w3 = w;
+	}
+
+	A = ctx->state[0];
+	B = ctx->state[1];
+	C = ctx->state[2];
+	D = ctx->state[3];
+	E = ctx->state[4];
+	F = ctx->state[5];
+	G = ctx->state[6];
+	H = ctx->state[7];
+
+	for (i = 0; i < 64; i += 8) {
+		P(A, B, C, D, E, F, G, H, wk[i]);
+		P(H, A, B, C, D, E, F, G, wk[i + 1]);
+		P(G, H, A, B, C, D, E, F, wk[i + 2]);
+		P(F, G, H, A, B, C, D, E, wk[i + 3]);
+		P(E, F, G, H, A, B, C, D, wk[i + 4]);
+		P(D, E, F, G, H, A, B, C, wk[i + 5]);
+		P(C, D, E, F, G, H, A, B, wk[i + 6]);
+		P(B, C, D, E, F, G, H, A, wk[i + 7]);
+	}
+
+	ctx->state[0] += A;
+	ctx->state[1] += B;
+	ctx->state[2] += C;
+	ctx->state[3] += D;
+	ctx->state[4] += E;
+	ctx->state[5] += F;
+	ctx->state[6] += G;
+	ctx->state[7] += H;
+}
+
+#undef P
+#undef F1
+
+void sha256_neon_csum_wd(const unsigned char *input, unsigned int ilen,
+			 unsigned char *output, unsigned int chunk_sz)
+{
+	sha256_csum_wd_fn(input, ilen, output, chunk_sz, sha256_neon_block);
+}
+
+/*
+ * W[i..i+3] = ROL1(W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]). W[i+3] needs W[i]
+ * as its W[t-3], which is patched in once the first three words are known.
+ */
+static inline uint32x4_t sha1_schedule(uint32x4_t w0, uint32x4_t w1,
+				       uint32x4_t w2, uint32x4_t w3)
+{
+	uint32x4_t zero = vdupq_n_u32(0);
+	uint32x4_t t, r;
+
+	t = veorq_u32(w0, vextq_u32(w0, w1, 2));
+	t = veorq_u32(t, w2);
+	t = veorq_u32(t, vextq_u32(w3, zero, 1));
+	r = VROL(t, 1);
+	t = vextq_u32(zero, r, 1);
+
+	return veorq_u32(r, VROL(t, 1));
+}
+
+#define F1(x, y, z)	(z ^ (x & (y ^ z)))
+#define F2(x, y, z)	(x ^ y ^ z)
+#define F3(x, y, z)	((x & y) | (z & (x | y)))
+
+#define P(a, b, c, d, e, f, wk) {			\
+	e += ROL(a, 5) + f(b, c, d) + (wk);		\
+	b = ROL(b, 30);					\
+}
+
+#define P5(f, i) {					\
+	P(A, B, C, D, E, f, wk[(i)]);			\
+	P(E, A, B, C, D, f, wk[(i) + 1]);		\
+	P(D, E, A, B, C, f, wk[(i) + 2]);		\
+	P(C, D, E, A, B, f, wk[(i) + 3]);		\
+	P(B, C, D, E, A, f, wk[(i) + 4]);		\
+}
+
+void sha1_neon_block(sha1_context *ctx, const unsigned char data[64])
+{
+	static const uint32_t k[4] = {
+		0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6,
+	};
+	uint32_t wk[80] __attribute__((aligned(16)));
+	uint32_t A, B, C, D, E;
+	uint32x4_t w0, w1, w2, w3, w, kv;
+	int i;
+
+	kv = vdupq_n_u32(k[0]);
+	w0 = load_be32x4(data);
+	w1 = load_be32x4(data + 16);
+	w2 = load_be32x4(data + 32);
+	w3 = load_be32x4(data + 48);
+	vst1q_u32(wk, vaddq_u32(w0, kv));
+	vst1q_u32(wk + 4, vaddq_u32(w1, kv));
+	vst1q_u32(wk + 8, vaddq_u32(w2, kv));
+	vst1q_u32(wk + 12, vaddq_u32(w3, kv));
+
+	/* The constant changes every 20 rounds, a multiple of four */
+	for (i = 16; i < 80; i += 4) {
+		kv = vdupq_n_u32(k[i / 20]);
+		w = sha1_schedule(w0, w1, w2, w3);
+		vst1q_u32(wk + i, vaddq_u32(w, kv));
+		w0 = w1;
+		w1 = w2;
+		w2 = w3;
+		w3 = w;
+	}
+
+	A = ctx->state[0];
+	B = ctx->state[1];
+	C = ctx->state[2];
+	D = ctx->state[3];
+	E = ctx->state[4];
+
+	for (i = 0; i < 20; i += 5)
+		P5(F1, i);
+	for (; i < 40; i += 5)
+		P5(F2, i);
+	for (; i < 60; i += 5)
+		P5(F3, i);
+	for (; i < 80; i += 5)
+		P5(F2, i);
+
+	ctx->state[0] += A;
+	ctx->state[1] += B;
+	ctx->state[2] += C;
+	ctx->state[3] += D;
+	ctx->state[4] += E;
+}
+
+void sha1_neon_csum_wd(const unsigned char *input, unsigned int ilen,
+		       unsigned char *output, unsigned int chunk_sz)
+{
+	sha1_csum_wd_fn(input, ilen, output, chunk_sz, sha1_neon_block);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2014 The Chromium OS Authors.
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <smp_job.h>
+
+/*
+ * Sandbox has no second CPU. A submitted job is held back until it is
+ * waited for and then run on the calling CPU, as if the secondary had
+ * only just finished it; callers see the same ordering as on real
+ * hardware, so their bookkeeping can be tested here.
+ */
+static smp_job_func smp_job_pending_func;
+static void *smp_job_pending_arg;
+
+int smp_job_submit(smp_job_func func, void *arg, const void *in,
+		   size_t in_len, void *out, size_t out_len)
+{
+	if (smp_job_pending_func)
+		return -EBUSY;
+	smp_job_pending_func = func;
+	smp_job_pending_arg = arg;
+
+	return 0;
+}
+
+int smp_job_wait(void)
+{
+	smp_job_func func = smp_job_pending_func;
+
+	if (!func)
+		return -ENOENT;
+	smp_job_pending_func = NULL;
+	func(smp_job_pending_arg);
+
+	return 0;
+}
+
+void smp_job_stop(void)
+{
+	smp_job_wait();
+}
@@ -77,7 +77,7 @@ int dram_init(void)
 #ifdef CONFIG_GENERIC_MMC
 static void mmc_pinmux_setup(int sdc)
 {
-	unsigned int pin;
+	unsigned int pin, last;
 
 	switch (sdc) {
 	case 0:
@@ -100,7 +100,13 @@ static void mmc_pinmux_setup(int sdc)
 
 	case 2:
 		/* CMD-PC6, CLK-PC7, D0-PC8, D1-PC9, D2-PC10, D3-PC11 */
-		for (pin = SUNXI_GPC(6); pin <= SUNXI_GPC(11); pin++) {
+		last = SUNXI_GPC(11);
+#ifdef CONFIG_MMC_SUNXI_8BIT_SLOT
+		/* D4-PC12, D5-PC13, D6-PC14, D7-PC15 */
+		if (CONFIG_MMC_SUNXI_8BIT_SLOT == 2)
+			last = SUNXI_GPC(15);
+#endif
+		for (pin = SUNXI_GPC(6); pin <= last; pin++) {
 			sunxi_gpio_set_cfgpin(pin, SUNXI_GPC6_SDC2);
 			sunxi_gpio_set_pull(pin, SUNXI_GPIO_PULL_UP);
 			sunxi_gpio_set_drv(pin, 2);
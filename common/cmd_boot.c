@@ -10,6 +10,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <environment.h>
 #include <net.h>
 
 #ifdef CONFIG_CMD_GO
@@ -32,6 +33,8 @@ static int do_go(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	addr = simple_strtoul(argv[1], NULL, 16);
 
+	env_save_flush();
+
 	printf ("## Starting application at 0x%08lX ...\n", addr);
 
 	/*
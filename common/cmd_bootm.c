@@ -51,6 +51,10 @@
 #include <linux/lzo.h>
 #endif /* CONFIG_LZO */
 
+#ifdef CONFIG_LZ4
+#include <lz4.h>
+#endif /* CONFIG_LZ4 */
+
 DECLARE_GLOBAL_DATA_PTR;
 
 #ifndef CONFIG_SYS_BOOTM_LEN
@@ -209,6 +213,9 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 {
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = getenv_yesno("verify");
+#if defined(CONFIG_FIT)
+	fit_verify_reset();
+#endif
 
 	boot_start_lmb(&images);
 
@@ -378,9 +385,9 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 	__maybe_unused uint unc_len = CONFIG_SYS_BOOTM_LEN;
 	int no_overlap = 0;
 	void *load_buf, *image_buf;
-#if defined(CONFIG_LZMA) || defined(CONFIG_LZO)
+#if defined(CONFIG_LZMA) || defined(CONFIG_LZO) || defined(CONFIG_LZ4)
 	int ret;
-#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) */
+#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) || defined(CONFIG_LZ4) */
 
 	const char *type_name = genimg_get_type_name(os.type);
 
@@ -399,6 +406,13 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 		break;
 #ifdef CONFIG_GZIP
 	case IH_COMP_GZIP:
+		if (images->legacy_hdr_valid &&
+		    image_stream_take(images->legacy_hdr_os, &image_len)) {
+			printf("   Uncompressed %s while loading ... ",
+			       type_name);
+			*load_end = load + image_len;
+			break;
+		}
 		printf("   Uncompressing %s ... ", type_name);
 		if (gunzip(load_buf, unc_len, image_buf, &image_len) != 0) {
 			puts("GUNZIP: uncompress, out-of-mem or overwrite "
@@ -470,6 +484,25 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 		break;
 	}
 #endif /* CONFIG_LZO */
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t size = unc_len;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = ulz4fn(image_buf, image_len, load_buf, &size);
+		if (ret) {
+			printf("LZ4: uncompress or overwrite error %d "
+			      "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + size;
+		break;
+	}
+#endif /* CONFIG_LZ4 */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
@@ -626,6 +659,10 @@ static int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc,
 
 	images->state |= states;
 
+	/* The OS is not expected to return, so save the environment now */
+	if (states & BOOTM_STATE_OS_GO)
+		env_save_flush();
+
 	/*
 	 * Work through the states and see how far we get. We stop on
 	 * any error.
@@ -776,6 +813,8 @@ static int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 
 int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	int ret;
+
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	static int relocated = 0;
 
@@ -813,7 +852,7 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return do_bootm_subcommand(cmdtp, flag, argc, argv);
 	}
 
-	return do_bootm_states(cmdtp, flag, argc, argv, BOOTM_STATE_START |
+	ret = do_bootm_states(cmdtp, flag, argc, argv, BOOTM_STATE_START |
 		BOOTM_STATE_FINDOS | BOOTM_STATE_FINDOTHER |
 		BOOTM_STATE_LOADOS |
 #if defined(CONFIG_PPC) || defined(CONFIG_MIPS)
@@ -821,6 +860,12 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #endif
 		BOOTM_STATE_OS_PREP | BOOTM_STATE_OS_FAKE_GO |
 		BOOTM_STATE_OS_GO, &images, 1);
+#if defined(CONFIG_FIT)
+	/* the boot failed, stop any hashing still under way */
+	fit_verify_reset();
+#endif
+
+	return ret;
 }
 
 int bootm_maybe_autostart(cmd_tbl_t *cmdtp, const char *cmd)
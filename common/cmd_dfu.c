@@ -53,6 +53,7 @@ static int do_dfu(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			goto exit;
 
 		usb_gadget_handle_interrupts();
+		dfu_poll();
 	}
 exit:
 	g_dnl_unregister();
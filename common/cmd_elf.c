@@ -15,9 +15,11 @@
 
 #include <common.h>
 #include <command.h>
+#include <environment.h>
 #include <linux/ctype.h>
 #include <net.h>
 #include <elf.h>
+#include <smp_job.h>
 #include <vxworks.h>
 
 #if defined(CONFIG_WALNUT) || defined(CONFIG_SYS_VXWORKS_MAC_PTR)
@@ -34,6 +36,8 @@ unsigned long do_bootelf_exec(ulong (*entry)(int, char * const[]),
 {
 	unsigned long ret;
 
+	smp_job_stop();
+
 	/*
 	 * QNX images require the data cache is disabled.
 	 * Data cache is already flushed, so just turn it off.
@@ -123,6 +127,8 @@ int do_bootelf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	else
 		addr = load_elf_image_shdr(addr);
 
+	env_save_flush();
+
 	printf("## Starting application at 0x%08lx ...\n", addr);
 
 	/*
@@ -258,10 +264,13 @@ int do_bootvx(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		/* leave addr as load_addr */
 	}
 
+	env_save_flush();
+
 	printf("## Using bootline (@ 0x%lx): %s\n", bootaddr,
 			(char *) bootaddr);
 	printf("## Starting vxWorks at 0x%08lx ...\n", addr);
 
+	smp_job_stop();
 	dcache_disable();
 	((void (*)(int)) addr) (0);
 
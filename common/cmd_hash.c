@@ -20,7 +20,14 @@ static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char *s;
 #ifdef CONFIG_HASH_VERIFY
 	int flags = HASH_FLAG_ENV;
+#else
+	const int flags = HASH_FLAG_ENV;
+#endif
 
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return hash_bench(argc > 2 ? simple_strtoul(argv[2], NULL, 16) :
+				  HASH_BENCH_SIZE) ? CMD_RET_FAILURE : 0;
+#ifdef CONFIG_HASH_VERIFY
 	if (argc < 4)
 		return CMD_RET_USAGE;
 	if (!strcmp(argv[1], "-v")) {
@@ -28,8 +35,6 @@ static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		argc--;
 		argv++;
 	}
-#else
-	const int flags = HASH_FLAG_ENV;
 #endif
 	/* Move forward to 'algorithm' parameter */
 	argc--;
@@ -46,13 +51,17 @@ U_BOOT_CMD(
 	"algorithm address count [[*]sum_dest]\n"
 		"    - compute message digest [save to env var / *address]\n"
 	"hash -v algorithm address count [*]sum\n"
-		"    - verify hash of memory area with env var / *address"
+		"    - verify hash of memory area with env var / *address\n"
+	"hash bench [size]\n"
+		"    - throughput of each algorithm over size (hex) bytes"
 );
 #else
 U_BOOT_CMD(
 	hash,	5,	1,	do_hash,
 	"compute message digest",
 	"algorithm address count [[*]sum_dest]\n"
-		"    - compute message digest [save to env var / *address]"
+		"    - compute message digest [save to env var / *address]\n"
+	"hash bench [size]\n"
+		"    - throughput of each algorithm over size (hex) bytes"
 );
 #endif
@@ -8,6 +8,9 @@
 #include <common.h>
 #include <command.h>
 #include <mmc.h>
+#ifdef CONFIG_CMD_MMC_SWRITE
+#include <image-sparse.h>
+#endif
 
 static int curr_device = -1;
 #ifndef CONFIG_GENERIC_MMC
@@ -131,6 +134,57 @@ U_BOOT_CMD(
 	"- display info of the current MMC device"
 );
 
+#ifdef CONFIG_CMD_MMC_SWRITE
+static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
+				 lbaint_t blkcnt, const void *buffer)
+{
+	struct mmc *mmc = info->priv;
+
+	return mmc->block_dev.block_write(mmc->block_dev.dev, blk, blkcnt,
+					  buffer);
+}
+
+/* Write the Android sparse image at @addr from block @blk on */
+static int do_mmc_swrite(struct mmc *mmc, void *addr, u32 blk)
+{
+	struct sparse_storage info;
+	struct sparse_stream s;
+	int ret;
+
+	if (!is_sparse_image(addr)) {
+		printf("Not a sparse image\n");
+		return 1;
+	}
+
+	printf("\nMMC swrite: dev # %d, block # %d ... ", curr_device, blk);
+
+	mmc_init(mmc);
+	if (mmc_getwp(mmc) == 1) {
+		printf("Error: card is write protected!\n");
+		return 1;
+	}
+	if (blk >= mmc->block_dev.lba) {
+		printf("Error: block # %d is past the end\n", blk);
+		return 1;
+	}
+
+	info.blksz = mmc->block_dev.blksz;
+	info.start = blk;
+	info.size = mmc->block_dev.lba - blk;
+	info.priv = mmc;
+	info.write = mmc_sparse_write;
+
+	/* The image ends itself, so its length need not be known */
+	sparse_stream_start(&s, &info);
+	sparse_stream_write(&s, addr, ~0UL - (ulong)addr);
+	ret = sparse_stream_finish(&s);
+
+	printf(LBAFU " blocks written, " LBAFU " skipped: %s\n",
+	       s.written, s.skipped, ret ? "ERROR" : "OK");
+	return ret ? 1 : 0;
+}
+#endif
+
 static int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	enum mmc_state state;
@@ -367,6 +421,21 @@ static int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #endif /* CONFIG_SUPPORT_EMMC_BOOT */
 	}
 
+#ifdef CONFIG_CMD_MMC_SWRITE
+	else if (argc == 4 && strcmp(argv[1], "swrite") == 0) {
+		struct mmc *mmc = find_mmc_device(curr_device);
+		void *addr = (void *)simple_strtoul(argv[2], NULL, 16);
+		u32 blk = simple_strtoul(argv[3], NULL, 16);
+
+		if (!mmc) {
+			printf("no mmc device at slot %x\n", curr_device);
+			return 1;
+		}
+
+		return do_mmc_swrite(mmc, addr, blk);
+	}
+#endif
+
 	else if (argc == 3 && strcmp(argv[1], "setdsr") == 0) {
 		struct mmc *mmc = find_mmc_device(curr_device);
 		u32 val = simple_strtoul(argv[2], NULL, 16);
@@ -458,6 +527,9 @@ U_BOOT_CMD(
 	"MMC sub system",
 	"read addr blk# cnt\n"
 	"mmc write addr blk# cnt\n"
+#ifdef CONFIG_CMD_MMC_SWRITE
+	"mmc swrite addr blk# - write Android sparse image at addr from blk#\n"
+#endif
 	"mmc erase blk# cnt\n"
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
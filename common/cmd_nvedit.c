@@ -493,6 +493,7 @@ int do_env_callback(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	puts("Active callback bindings:\n");
 	printf("\t%-20s %-20s\n", "Variable Name", "Callback Name");
 	printf("\t%-20s %-20s\n", "-------------", "-------------");
+	himport_finish_r(&env_htab);
 	hwalk_r(&env_htab, print_active_callback);
 	return 0;
 }
@@ -565,6 +566,7 @@ int do_env_flags(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		"Variable Access");
 	printf("\t%-20s %-20s %-20s\n", "-------------", "-------------",
 		"---------------");
+	himport_finish_r(&env_htab);
 	hwalk_r(&env_htab, print_active_flags);
 	return 0;
 }
@@ -684,6 +686,61 @@ ulong getenv_ulong(const char *name, int base, ulong default_val)
 
 #ifndef CONFIG_SPL_BUILD
 #if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_ENV_IS_NOWHERE)
+#ifdef ENV_SAVE_DEFER
+static int env_save_holds;	/* commands and scripts running */
+static int env_save_pending;	/* a saveenv was put off */
+
+void env_save_hold(void)
+{
+	env_save_holds++;
+}
+
+int env_save_release(void)
+{
+	if (!env_save_holds || --env_save_holds)
+		return 0;
+	if (env_save_flush()) {
+		puts("## Error: deferred saveenv failed\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int env_save_flush(void)
+{
+	if (!env_save_pending)
+		return 0;
+	env_save_pending = 0;
+
+	printf("Saving Environment to %s...\n", env_name_spec);
+
+	return saveenv() ? 1 : 0;
+}
+
+static int do_env_save(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "-f"))
+		return CMD_RET_USAGE;
+
+	env_save_pending = 1;
+
+	/* saveenv itself holds once; more means a script is running */
+	if (argc == 1 && env_save_holds > 1)
+		return 0;
+
+	return env_save_flush();
+}
+
+U_BOOT_CMD(
+	saveenv, 2, 0,	do_env_save,
+	"save environment variables to persistent storage",
+	"[-f]\n"
+	"    - within a script the write is left to the end of the script;\n"
+	"      '-f' writes straight away"
+);
+#else
 static int do_env_save(cmd_tbl_t *cmdtp, int flag, int argc,
 		       char * const argv[])
 {
@@ -697,6 +754,7 @@ U_BOOT_CMD(
 	"save environment variables to persistent storage",
 	""
 );
+#endif /* ENV_SAVE_DEFER */
 #endif
 #endif /* CONFIG_SPL_BUILD */
 
@@ -1109,7 +1167,11 @@ static cmd_tbl_t cmd_env_sub[] = {
 	U_BOOT_CMD_MKENT(run, CONFIG_SYS_MAXARGS, 1, do_run, "", ""),
 #endif
 #if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_ENV_IS_NOWHERE)
+#ifdef ENV_SAVE_DEFER
+	U_BOOT_CMD_MKENT(save, 2, 0, do_env_save, "", ""),
+#else
 	U_BOOT_CMD_MKENT(save, 1, 0, do_env_save, "", ""),
+#endif
 #endif
 	U_BOOT_CMD_MKENT(set, CONFIG_SYS_MAXARGS, 0, do_env_set, "", ""),
 #if defined(CONFIG_CMD_ENV_EXISTS)
@@ -1181,7 +1243,11 @@ static char env_help_text[] =
 	"env run var [...] - run commands in an environment variable\n"
 #endif
 #if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_ENV_IS_NOWHERE)
+#ifdef ENV_SAVE_DEFER
+	"env save [-f] - save environment [now, even from a script]\n"
+#else
 	"env save - save environment\n"
+#endif
 #endif
 	"env set [-f] name [arg ...]\n";
 #endif
@@ -0,0 +1,51 @@
+/*
+ * lz4 uncompress command, made from cmd_lzmadec.c
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <lz4.h>
+#include <asm/io.h>
+
+static int do_unlz4(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	unsigned long src, dst;
+	size_t src_len = ~0UL, dst_len = ~0UL;
+	int ret;
+
+	switch (argc) {
+	case 5:
+		src_len = simple_strtoul(argv[4], NULL, 16);
+		/* fall through */
+	case 4:
+		dst_len = simple_strtoul(argv[3], NULL, 16);
+		/* fall through */
+	case 3:
+		src = simple_strtoul(argv[1], NULL, 16);
+		dst = simple_strtoul(argv[2], NULL, 16);
+		break;
+	default:
+		return CMD_RET_USAGE;
+	}
+
+	ret = ulz4fn(map_sysmem(src, 0), src_len, map_sysmem(dst, dst_len),
+		     &dst_len);
+	if (ret) {
+		printf("LZ4: uncompress error %d\n", ret);
+		return 1;
+	}
+	printf("Uncompressed size: %lu = 0x%lX\n", (ulong)dst_len,
+	       (ulong)dst_len);
+	setenv_hex("filesize", dst_len);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	unlz4,    5,    1,    do_unlz4,
+	"lz4 uncompress a memory region",
+	"srcaddr dstaddr [dstsize [srcsize]]\n"
+	"    - srcsize is needed for the legacy (lz4 -l) format only"
+);
@@ -10,6 +10,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <div64.h>
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
 #include <part.h>
@@ -17,6 +18,19 @@
 
 #ifdef CONFIG_USB_STORAGE
 static int usb_stor_curr_dev = -1; /* current device */
+
+/* Finish a read or write message with the result and the rate */
+static void usb_stor_show_result(block_dev_desc_t *stor_dev, ulong n,
+				 ulong cnt, ulong time, const char *what)
+{
+	printf("%ld blocks %s: %s", n, what, (n == cnt) ? "OK" : "ERROR");
+	if (n && time > 0) {
+		puts(" (");
+		print_size(lldiv((u64)n * stor_dev->blksz * 1000, time), "/s");
+		puts(")");
+	}
+	puts("\n");
+}
 #endif
 #ifdef CONFIG_USB_HOST_ETHER
 static int usb_ether_curr_dev = -1; /* current ethernet device */
@@ -581,14 +595,15 @@ static int do_usb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			unsigned long addr = simple_strtoul(argv[2], NULL, 16);
 			unsigned long blk  = simple_strtoul(argv[3], NULL, 16);
 			unsigned long cnt  = simple_strtoul(argv[4], NULL, 16);
-			unsigned long n;
+			unsigned long n, time;
 			printf("\nUSB read: device %d block # %ld, count %ld"
 				" ... ", usb_stor_curr_dev, blk, cnt);
 			stor_dev = usb_stor_get_dev(usb_stor_curr_dev);
+			time = get_timer(0);
 			n = stor_dev->block_read(usb_stor_curr_dev, blk, cnt,
 						 (ulong *)addr);
-			printf("%ld blocks read: %s\n", n,
-				(n == cnt) ? "OK" : "ERROR");
+			time = get_timer(time);
+			usb_stor_show_result(stor_dev, n, cnt, time, "read");
 			if (n == cnt)
 				return 0;
 			return 1;
@@ -603,14 +618,15 @@ static int do_usb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			unsigned long addr = simple_strtoul(argv[2], NULL, 16);
 			unsigned long blk  = simple_strtoul(argv[3], NULL, 16);
 			unsigned long cnt  = simple_strtoul(argv[4], NULL, 16);
-			unsigned long n;
+			unsigned long n, time;
 			printf("\nUSB write: device %d block # %ld, count %ld"
 				" ... ", usb_stor_curr_dev, blk, cnt);
 			stor_dev = usb_stor_get_dev(usb_stor_curr_dev);
+			time = get_timer(0);
 			n = stor_dev->block_write(usb_stor_curr_dev, blk, cnt,
 						(ulong *)addr);
-			printf("%ld blocks write: %s\n", n,
-				(n == cnt) ? "OK" : "ERROR");
+			time = get_timer(time);
+			usb_stor_show_result(stor_dev, n, cnt, time, "write");
 			if (n == cnt)
 				return 0;
 			return 1;
@@ -11,6 +11,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <environment.h>
 #include <linux/ctype.h>
 
 /*
@@ -529,11 +530,21 @@ enum command_ret_t cmd_process(int flag, int argc, char * const argv[],
 	}
 #endif
 
+#ifdef ENV_SAVE_DEFER
+	/* "reset" does not come back; write out a deferred saveenv first */
+	if (!rc && cmdtp->cmd == do_reset)
+		env_save_flush();
+#endif
+
 	/* If OK so far, then do the command */
 	if (!rc) {
 		if (ticks)
 			*ticks = get_timer(0);
+		env_save_hold();
 		rc = cmd_call(cmdtp, flag, argc, argv);
+		/* a failed deferred saveenv fails the command that ran it */
+		if (env_save_release() && !rc)
+			rc = CMD_RET_FAILURE;
 		if (ticks)
 			*ticks = get_timer(*ticks);
 		*repeatable &= cmdtp->repeatable;
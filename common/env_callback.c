@@ -133,3 +133,36 @@ static int on_callbacks(const char *name, const char *value, enum env_op op,
 	return 0;
 }
 U_BOOT_ENV_CALLBACK(callbacks, on_callbacks);
+
+#ifdef CONFIG_ENV_LAZY_IMPORT
+static int import_callback(const char *name, const char *value)
+{
+	ENTRY e, *ep;
+
+	/* looking the variable up imports it, running its callback */
+	e.key	= name;
+	e.data	= NULL;
+	hsearch_r(e, FIND, &ep, &env_htab, 0);
+
+	return 0;
+}
+
+/*
+ * Import the variables with a callback binding after a lazy import
+ */
+void env_callback_import(void)
+{
+	const char *list = getenv(ENV_CALLBACK_VAR);
+
+#ifdef CONFIG_REGEX
+	/* the bindings may be regular expressions, so check them all */
+	if (list != NULL) {
+		himport_finish_r(&env_htab);
+		return;
+	}
+#endif
+	env_attr_walk(ENV_CALLBACK_LIST_STATIC, import_callback);
+	if (list != NULL)
+		env_attr_walk(list, import_callback);
+}
+#endif
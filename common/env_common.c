@@ -97,6 +97,24 @@ char *getenv_default(const char *name)
 	return ret_val;
 }
 
+/*
+ * Import a complete '\0' separated environment. With CONFIG_ENV_LAZY_IMPORT
+ * only an index is built, apart from the variables with a callback, which
+ * must take effect at once as they would with a full import.
+ */
+static int env_import_all(const char *data, size_t size, int flag)
+{
+#ifdef CONFIG_ENV_LAZY_IMPORT
+	if (!himport_lazy_r(&env_htab, data, size, flag))
+		return 0;
+	env_callback_import();
+
+	return 1;
+#else
+	return himport_r(&env_htab, data, size, '\0', flag, 0, NULL);
+#endif
+}
+
 void set_default_env(const char *s)
 {
 	int flags = 0;
@@ -119,9 +137,8 @@ void set_default_env(const char *s)
 		puts("Using default environment\n\n");
 	}
 
-	if (himport_r(&env_htab, (char *)default_environment,
-			sizeof(default_environment), '\0', flags,
-			0, NULL) == 0)
+	if (env_import_all((char *)default_environment,
+			sizeof(default_environment), flags) == 0)
 		error("Environment import failed: errno = %d\n", errno);
 
 	gd->flags |= GD_FLG_ENV_READY;
@@ -159,8 +176,7 @@ int env_import(const char *buf, int check)
 		}
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0,
-			0, NULL)) {
+	if (env_import_all((char *)ep->data, ENV_SIZE, 0)) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 1;
 	}
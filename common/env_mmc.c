@@ -96,6 +96,20 @@ static void fini_mmc_for_env(struct mmc *mmc)
 #endif
 }
 
+static inline int read_env(struct mmc *mmc, unsigned long size,
+			   unsigned long offset, const void *buffer)
+{
+	uint blk_start, blk_cnt, n;
+
+	blk_start	= ALIGN(offset, mmc->read_bl_len) / mmc->read_bl_len;
+	blk_cnt		= ALIGN(size, mmc->read_bl_len) / mmc->read_bl_len;
+
+	n = mmc->block_dev.block_read(CONFIG_SYS_MMC_ENV_DEV, blk_start,
+					blk_cnt, (uchar *)buffer);
+
+	return (n == blk_cnt) ? 0 : -1;
+}
+
 #ifdef CONFIG_CMD_SAVEENV
 static inline int write_env(struct mmc *mmc, unsigned long size,
 			    unsigned long offset, const void *buffer)
@@ -111,6 +125,56 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	return (n == blk_cnt) ? 0 : -1;
 }
 
+#ifdef CONFIG_ENV_MMC_INCREMENTAL
+/*
+ * Read back what the card holds and write only the runs of blocks that
+ * differ. A new value shifts everything exported after it, so this saves
+ * most where the unused tail of a large environment area stays the same.
+ * Reading is far cheaper than writing, and unlike a copy kept in memory
+ * it cannot go stale when the card is changed.
+ */
+static int write_env_changed(struct mmc *mmc, unsigned long offset,
+			     const u_char *buffer)
+{
+	uint bl_len = mmc->write_bl_len;
+	uint blk_start, blk_cnt, start, end, n, written = 0;
+	u_char *old;
+
+	if (CONFIG_ENV_SIZE % bl_len)
+		return write_env(mmc, CONFIG_ENV_SIZE, offset, buffer);
+
+	old = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	if (!old || read_env(mmc, CONFIG_ENV_SIZE, offset, old)) {
+		free(old);
+		return write_env(mmc, CONFIG_ENV_SIZE, offset, buffer);
+	}
+
+	blk_start	= ALIGN(offset, bl_len) / bl_len;
+	blk_cnt		= CONFIG_ENV_SIZE / bl_len;
+
+	for (start = 0; start < blk_cnt; start = end) {
+		end = start + 1;
+		if (!memcmp(buffer + start * bl_len, old + start * bl_len,
+			    bl_len))
+			continue;
+		while (end < blk_cnt &&
+		       memcmp(buffer + end * bl_len, old + end * bl_len, bl_len))
+			end++;
+
+		n = mmc->block_dev.block_write(CONFIG_SYS_MMC_ENV_DEV,
+					       blk_start + start, end - start,
+					       (u_char *)buffer + start * bl_len);
+		if (n != end - start)
+			break;
+		written += n;
+	}
+	free(old);
+	debug("%s: wrote %u of %u blocks\n", __func__, written, blk_cnt);
+
+	return start < blk_cnt ? -1 : 0;
+}
+#endif
+
 #ifdef CONFIG_ENV_OFFSET_REDUND
 static unsigned char env_flags;
 #endif
@@ -151,7 +215,12 @@ int saveenv(void)
 
 	printf("Writing to %sMMC(%d)... ", copy ? "redundant " : "",
 	       CONFIG_SYS_MMC_ENV_DEV);
-	if (write_env(mmc, CONFIG_ENV_SIZE, offset, (u_char *)env_new)) {
+#ifdef CONFIG_ENV_MMC_INCREMENTAL
+	ret = write_env_changed(mmc, offset, (u_char *)env_new);
+#else
+	ret = write_env(mmc, CONFIG_ENV_SIZE, offset, (u_char *)env_new);
+#endif
+	if (ret) {
 		puts("failed\n");
 		ret = 1;
 		goto fini;
@@ -170,20 +239,6 @@ fini:
 }
 #endif /* CONFIG_CMD_SAVEENV */
 
-static inline int read_env(struct mmc *mmc, unsigned long size,
-			   unsigned long offset, const void *buffer)
-{
-	uint blk_start, blk_cnt, n;
-
-	blk_start	= ALIGN(offset, mmc->read_bl_len) / mmc->read_bl_len;
-	blk_cnt		= ALIGN(size, mmc->read_bl_len) / mmc->read_bl_len;
-
-	n = mmc->block_dev.block_read(CONFIG_SYS_MMC_ENV_DEV, blk_start,
-					blk_cnt, (uchar *)buffer);
-
-	return (n == blk_cnt) ? 0 : -1;
-}
-
 #ifdef CONFIG_ENV_OFFSET_REDUND
 void env_relocate_spec(void)
 {
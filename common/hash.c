@@ -12,12 +12,191 @@
 
 #include <common.h>
 #include <command.h>
+#include <malloc.h>
 #include <hw_sha.h>
 #include <hash.h>
 #include <sha1.h>
 #include <sha256.h>
+#include <sha_neon.h>
+#include <watchdog.h>
+#include <div64.h>
 #include <asm/io.h>
 #include <asm/errno.h>
+#include <u-boot/md5.h>
+
+#ifdef CONFIG_CMD_SHA1SUM
+static int hash_init_sha1(struct hash_algo *algo, void **ctxp)
+{
+	sha1_context *ctx = malloc(sizeof(sha1_context));
+
+	if (!ctx)
+		return -ENOMEM;
+	sha1_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_sha1(struct hash_algo *algo, void *ctx, const void *buf,
+			    unsigned int size, int is_last)
+{
+	sha1_update((sha1_context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_sha1(struct hash_algo *algo, void *ctx, void *dest_buf,
+			    int size)
+{
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	sha1_finish((sha1_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SHA256
+static int hash_init_sha256(struct hash_algo *algo, void **ctxp)
+{
+	sha256_context *ctx = malloc(sizeof(sha256_context));
+
+	if (!ctx)
+		return -ENOMEM;
+	sha256_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_sha256(struct hash_algo *algo, void *ctx,
+			      const void *buf, unsigned int size, int is_last)
+{
+	sha256_update((sha256_context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_sha256(struct hash_algo *algo, void *ctx, void
+			      *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	sha256_finish((sha256_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SHA_NEON
+#ifdef CONFIG_CMD_SHA1SUM
+static int hash_update_sha1_neon(struct hash_algo *algo, void *ctx,
+				 const void *buf, unsigned int size, int is_last)
+{
+	sha1_update_fn((sha1_context *)ctx, buf, size, sha1_neon_block);
+	return 0;
+}
+
+static int hash_finish_sha1_neon(struct hash_algo *algo, void *ctx,
+				 void *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	sha1_finish_fn((sha1_context *)ctx, dest_buf, sha1_neon_block);
+	free(ctx);
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SHA256
+static int hash_update_sha256_neon(struct hash_algo *algo, void *ctx,
+				   const void *buf, unsigned int size,
+				   int is_last)
+{
+	sha256_update_fn((sha256_context *)ctx, buf, size, sha256_neon_block);
+	return 0;
+}
+
+static int hash_finish_sha256_neon(struct hash_algo *algo, void *ctx,
+				   void *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	sha256_finish_fn((sha256_context *)ctx, dest_buf, sha256_neon_block);
+	free(ctx);
+	return 0;
+}
+#endif
+#endif
+
+#ifdef CONFIG_MD5
+static void hash_md5_wd(const unsigned char *input, unsigned int ilen,
+			unsigned char *output, unsigned int chunk_sz)
+{
+	md5_wd((unsigned char *)input, ilen, output, chunk_sz);
+}
+
+static int hash_init_md5(struct hash_algo *algo, void **ctxp)
+{
+	struct MD5Context *ctx = malloc(sizeof(struct MD5Context));
+
+	if (!ctx)
+		return -ENOMEM;
+	MD5Init(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_md5(struct hash_algo *algo, void *ctx, const void *buf,
+			   unsigned int size, int is_last)
+{
+	MD5Update((struct MD5Context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_md5(struct hash_algo *algo, void *ctx, void *dest_buf,
+			   int size)
+{
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	MD5Final(dest_buf, (struct MD5Context *)ctx);
+	free(ctx);
+	return 0;
+}
+#endif
+
+static int hash_init_crc32(struct hash_algo *algo, void **ctxp)
+{
+	uint32_t *ctx = malloc(sizeof(uint32_t));
+
+	if (!ctx)
+		return -ENOMEM;
+	*ctx = 0;
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_crc32(struct hash_algo *algo, void *ctx,
+			     const void *buf, unsigned int size, int is_last)
+{
+	*((uint32_t *)ctx) = crc32(*((uint32_t *)ctx), buf, size);
+	return 0;
+}
+
+static int hash_finish_crc32(struct hash_algo *algo, void *ctx, void *dest_buf,
+			     int size)
+{
+	uint32_t crc;
+
+	if (size < algo->digest_size)
+		return -ENOSPC;
+
+	crc = htonl(*((uint32_t *)ctx));
+	memcpy(dest_buf, &crc, sizeof(crc));
+	free(ctx);
+	return 0;
+}
 
 /*
  * These are the hash algorithms we support. Chips which support accelerated
@@ -41,6 +220,35 @@ static struct hash_algo hash_algo[] = {
 		hw_sha256,
 		CHUNKSZ_SHA256,
 	},
+#endif
+	/*
+	 * CONFIG_SHA_NEON computes the message schedule with NEON. Being
+	 * listed ahead of the generic versions these are the ones found by
+	 * name; 'hash bench' still runs both.
+	 */
+#ifdef CONFIG_SHA_NEON
+#ifdef CONFIG_CMD_SHA1SUM
+	{
+		"sha1",
+		SHA1_SUM_LEN,
+		sha1_neon_csum_wd,
+		CHUNKSZ_SHA1,
+		hash_init_sha1,
+		hash_update_sha1_neon,
+		hash_finish_sha1_neon,
+	},
+#endif
+#ifdef CONFIG_SHA256
+	{
+		"sha256",
+		SHA256_SUM_LEN,
+		sha256_neon_csum_wd,
+		CHUNKSZ_SHA256,
+		hash_init_sha256,
+		hash_update_sha256_neon,
+		hash_finish_sha256_neon,
+	},
+#endif
 #endif
 	/*
 	 * This is CONFIG_CMD_SHA1SUM instead of CONFIG_SHA1 since otherwise
@@ -53,6 +261,9 @@ static struct hash_algo hash_algo[] = {
 		SHA1_SUM_LEN,
 		sha1_csum_wd,
 		CHUNKSZ_SHA1,
+		hash_init_sha1,
+		hash_update_sha1,
+		hash_finish_sha1,
 	},
 #define MULTI_HASH
 #endif
@@ -62,14 +273,31 @@ static struct hash_algo hash_algo[] = {
 		SHA256_SUM_LEN,
 		sha256_csum_wd,
 		CHUNKSZ_SHA256,
+		hash_init_sha256,
+		hash_update_sha256,
+		hash_finish_sha256,
 	},
 #define MULTI_HASH
+#endif
+#ifdef CONFIG_MD5
+	{
+		"md5",
+		16,
+		hash_md5_wd,
+		CHUNKSZ_MD5,
+		hash_init_md5,
+		hash_update_md5,
+		hash_finish_md5,
+	},
 #endif
 	{
 		"crc32",
 		4,
 		crc32_wd_buf,
 		CHUNKSZ_CRC32,
+		hash_init_crc32,
+		hash_update_crc32,
+		hash_finish_crc32,
 	},
 };
 
@@ -216,6 +444,20 @@ static struct hash_algo *find_hash_algo(const char *name)
 	return NULL;
 }
 
+int hash_lookup_algo(const char *algo_name, struct hash_algo **algop)
+{
+	struct hash_algo *algo;
+
+	algo = find_hash_algo(algo_name);
+	if (!algo) {
+		debug("Unknown hash algorithm '%s'\n", algo_name);
+		return -EPROTONOSUPPORT;
+	}
+	*algop = algo;
+
+	return 0;
+}
+
 static void show_hash(struct hash_algo *algo, ulong addr, ulong len,
 		      u8 *output)
 {
@@ -226,6 +468,144 @@ static void show_hash(struct hash_algo *algo, ulong addr, ulong len,
 		printf("%02x", output[i]);
 }
 
+#ifdef CONFIG_HASH_LOAD
+/* State of the hash taken while a loader stores data, see hash_load_start() */
+static struct hash_algo *load_algo;
+static void *load_ctx;		/* NULL if hashed in one go at the end */
+static ulong load_done;		/* bytes hashed so far */
+
+int hash_load_start(void)
+{
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	const char *name;
+	int ret;
+
+	/* drop what an aborted load left behind */
+	if (load_ctx)
+		load_algo->hash_finish(load_algo, load_ctx, output,
+				       sizeof(output));
+	load_algo = NULL;
+	load_ctx = NULL;
+	load_done = 0;
+
+	name = getenv("loadhash");
+	if (!name)
+		return 0;
+
+	ret = hash_lookup_algo(name, &load_algo);
+	if (ret) {
+		printf("Unknown hash algorithm '%s'\n", name);
+		return ret;
+	}
+	if (load_algo->hash_init &&
+	    load_algo->hash_init(load_algo, &load_ctx))
+		load_ctx = NULL;
+
+	return 0;
+}
+
+void hash_load_update(ulong offset, const void *buf, ulong len)
+{
+	ulong skip;
+
+	if (!load_ctx || offset > load_done || offset + len <= load_done)
+		return;
+
+	/* a piece stored again, e.g. after a retransmit, is hashed once */
+	skip = load_done - offset;
+	load_algo->hash_update(load_algo, load_ctx, buf + skip, len - skip, 0);
+	load_done += len - skip;
+}
+
+int hash_load_busy(void)
+{
+	return load_ctx != NULL;
+}
+
+void hash_load_finish(ulong addr, ulong len)
+{
+	struct hash_algo *algo = load_algo;
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	const u8 *buf;
+	ulong n;
+
+	if (!algo)
+		return;
+	load_algo = NULL;
+
+	buf = map_sysmem(addr, len);
+	if (load_ctx) {
+		/* whatever the loader did not hand over */
+		while (load_done < len) {
+			n = min(len - load_done, (ulong)algo->chunk_size);
+			algo->hash_update(algo, load_ctx, buf + load_done, n,
+					  load_done + n == len);
+			load_done += n;
+			WATCHDOG_RESET();
+		}
+		algo->hash_finish(algo, load_ctx, output, sizeof(output));
+		load_ctx = NULL;
+	} else {
+		algo->hash_func_ws(buf, len, output, algo->chunk_size);
+	}
+	unmap_sysmem(buf);
+
+	show_hash(algo, addr, len, output);
+	printf("\n");
+	store_result(algo, output, "filehash", 1);
+}
+#endif
+
+#ifdef CONFIG_CMD_HASH
+/* Time each algorithm for at least this long */
+#define HASH_BENCH_MS	200
+
+int hash_bench(ulong len)
+{
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	char name[16];
+	ulong start, ms;
+	u64 bytes;
+	u8 *buf;
+	int i, j, n;
+
+	buf = memalign(ARCH_DMA_MINALIGN, len);
+	if (!buf) {
+		printf("Cannot allocate %#lx bytes\n", len);
+		return -ENOMEM;
+	}
+	for (i = 0; i < len; i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
+		algo = &hash_algo[i];
+		/* Tell apart several implementations of one algorithm */
+		for (n = 0, j = 0; j < i; j++)
+			if (!strcmp(hash_algo[j].name, algo->name))
+				n++;
+		if (n)
+			snprintf(name, sizeof(name), "%s#%d", algo->name,
+				 n + 1);
+		else
+			snprintf(name, sizeof(name), "%s", algo->name);
+		bytes = 0;
+		start = get_timer(0);
+		do {
+			algo->hash_func_ws(buf, len, output, algo->chunk_size);
+			bytes += len;
+			ms = get_timer(start);
+		} while (ms < HASH_BENCH_MS);
+
+		printf("%-10s %8llu bytes in %4lu ms, ", name, bytes, ms);
+		print_size(lldiv(bytes * 1000, ms), "/s\n");
+	}
+	free(buf);
+
+	return 0;
+}
+#endif
+
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size)
 {
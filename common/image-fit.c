@@ -16,6 +16,8 @@
 #else
 #include <common.h>
 #include <errno.h>
+#include <hash.h>
+#include <smp_job.h>
 #include <asm/io.h>
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
@@ -870,6 +872,21 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
  *     0, on success
  *    -1, when algo is unsupported
  */
+/* SHA-1 through the hash table if it is there, to get e.g. the NEON code */
+static void fit_sha1_csum(const void *data, int data_len, uint8_t *value)
+{
+#ifndef USE_HOSTCC
+	struct hash_algo *hash;
+
+	if (!hash_lookup_algo("sha1", &hash)) {
+		hash->hash_func_ws(data, data_len, value, hash->chunk_size);
+		return;
+	}
+#endif
+	sha1_csum_wd((unsigned char *)data, data_len,
+		     (unsigned char *)value, CHUNKSZ_SHA1);
+}
+
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
@@ -879,8 +896,7 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 		*((uint32_t *)value) = cpu_to_uimage(*((uint32_t *)value));
 		*value_len = 4;
 	} else if (IMAGE_ENABLE_SHA1 && strcmp(algo, "sha1") == 0) {
-		sha1_csum_wd((unsigned char *)data, data_len,
-			     (unsigned char *)value, CHUNKSZ_SHA1);
+		fit_sha1_csum(data, data_len, value);
 		*value_len = 20;
 	} else if (IMAGE_ENABLE_MD5 && strcmp(algo, "md5") == 0) {
 		md5_wd((unsigned char *)data, data_len, value, CHUNKSZ_MD5);
@@ -892,6 +908,296 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+#if defined(CONFIG_SMP_JOBS) && !defined(USE_HOSTCC)
+/*
+ * Verification plan: the hashes of every sub-image bootm is going to use
+ * are collected when the configuration is picked, one job per sub-image,
+ * and the second CPU works through them ahead of the boot CPU. Whenever
+ * the boot CPU needs a result it either collects a finished job, or runs
+ * the job itself while the second CPU takes the next one. Hash nodes
+ * over the same data with the same algorithm share one computation.
+ */
+#define FIT_VERIFY_IMAGES	8	/* sub-images planned per FIT */
+#define FIT_VERIFY_HASHES	4	/* hashes per sub-image */
+
+struct fit_hash_item {
+	const void *data;
+	size_t size;
+	int ret;
+	int value_len;
+	char algo[16];
+	uint8_t value[FIT_MAX_HASH_LEN];
+};
+
+/* The hashes of one sub-image; a job's output, so it owns its lines */
+struct fit_verify_job {
+	int count;
+	struct fit_hash_item item[FIT_VERIFY_HASHES];
+} __aligned(ARCH_DMA_MINALIGN);
+
+enum fit_verify_state {
+	FIT_VERIFY_PENDING,
+	FIT_VERIFY_RUNNING,
+	FIT_VERIFY_DONE,
+};
+
+/* Where the value of a hash node gets computed */
+struct fit_verify_ref {
+	int noffset;
+	short job;
+	short item;
+};
+
+static struct fit_verify_job fit_verify_jobs[FIT_VERIFY_IMAGES];
+
+static struct {
+	const void *fit;
+	int image[FIT_VERIFY_IMAGES];	/* image node of each job */
+	u8 state[FIT_VERIFY_IMAGES];
+	int njobs;
+	int nimages;			/* images looked at, with or without job */
+	int seen[FIT_VERIFY_IMAGES];
+	struct fit_verify_ref ref[FIT_VERIFY_IMAGES * FIT_VERIFY_HASHES];
+	int nrefs;
+	int running;			/* job on the second CPU, or -1 */
+} fit_plan = { .running = -1 };
+
+static void fit_verify_job_run(void *arg)
+{
+	struct fit_verify_job *job = arg;
+	struct fit_hash_item *item;
+	int i;
+
+	for (i = 0, item = job->item; i < job->count; i++, item++)
+		item->ret = calculate_hash(item->data, item->size, item->algo,
+					   item->value, &item->value_len);
+}
+
+/**
+ * fit_verify_reset() - forget all planned and computed hashes
+ *
+ * Results are only good as long as the FIT is not changed, so this is
+ * called at the start of each bootm and whenever a sub-image is copied
+ * over the FIT. It is also called when a command gives up, and parks the
+ * second CPU until there is work again.
+ */
+void fit_verify_reset(void)
+{
+	if (fit_plan.running >= 0)
+		smp_job_wait();
+	smp_job_stop();
+	fit_plan.running = -1;
+	fit_plan.fit = NULL;
+	fit_plan.njobs = 0;
+	fit_plan.nimages = 0;
+	fit_plan.nrefs = 0;
+}
+
+static struct fit_hash_item *fit_verify_find(const void *data, size_t size,
+					     const char *algo, int *jobp)
+{
+	struct fit_verify_job *job;
+	int i, j;
+
+	/* including the job being filled in */
+	for (j = 0, job = fit_verify_jobs; j <= fit_plan.njobs; j++, job++) {
+		for (i = 0; i < job->count; i++) {
+			if (job->item[i].data == data &&
+			    job->item[i].size == size &&
+			    !strcmp(job->item[i].algo, algo)) {
+				*jobp = j;
+				return &job->item[i];
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Plan the hashes of one sub-image */
+static void fit_verify_add_image(const void *fit, int image_noffset)
+{
+	struct fit_verify_job *job;
+	struct fit_hash_item *item;
+	struct fit_verify_ref *ref;
+	const void *data;
+	size_t size;
+	char *algo;
+	int noffset, ignore, i, j;
+
+	if (fit != fit_plan.fit) {
+		fit_verify_reset();
+		fit_plan.fit = fit;
+	}
+	for (i = 0; i < fit_plan.nimages; i++)
+		if (fit_plan.seen[i] == image_noffset)
+			return;
+	if (fit_plan.nimages == FIT_VERIFY_IMAGES ||
+	    fit_image_get_data(fit, image_noffset, &data, &size))
+		return;
+	fit_plan.seen[fit_plan.nimages++] = image_noffset;
+
+	job = &fit_verify_jobs[fit_plan.njobs];
+	job->count = 0;
+	for (noffset = fdt_first_subnode(fit, image_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (fit_plan.nrefs == ARRAY_SIZE(fit_plan.ref))
+			break;
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    strlen(algo) >= sizeof(item->algo))
+			continue;
+		if (IMAGE_ENABLE_IGNORE) {
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+			if (ignore)
+				continue;
+		}
+
+		item = fit_verify_find(data, size, algo, &j);
+		if (!item) {
+			if (job->count == FIT_VERIFY_HASHES)
+				continue;
+			j = fit_plan.njobs;
+			item = &job->item[job->count++];
+			item->data = data;
+			item->size = size;
+			strcpy(item->algo, algo);
+		}
+		ref = &fit_plan.ref[fit_plan.nrefs++];
+		ref->noffset = noffset;
+		ref->job = j;
+		ref->item = item - fit_verify_jobs[j].item;
+	}
+
+	if (job->count) {
+		fit_plan.image[fit_plan.njobs] = image_noffset;
+		fit_plan.state[fit_plan.njobs] = FIT_VERIFY_PENDING;
+		fit_plan.njobs++;
+	}
+}
+
+/* First job not yet started other than @skip, or -1 */
+static int fit_verify_next(int skip)
+{
+	int j;
+
+	for (j = 0; j < fit_plan.njobs; j++)
+		if (j != skip && fit_plan.state[j] == FIT_VERIFY_PENDING)
+			return j;
+
+	return -1;
+}
+
+/* Give the second CPU the next job other than @skip, if it is idle */
+static void fit_verify_kick(int skip)
+{
+	struct fit_verify_job *job;
+	int j;
+
+	j = fit_verify_next(skip);
+	if (fit_plan.running >= 0)
+		return;
+	if (j < 0) {
+		/* nothing left for it, don't leave it running */
+		smp_job_stop();
+		return;
+	}
+
+	job = &fit_verify_jobs[j];
+	if (smp_job_submit(fit_verify_job_run, job, job->item[0].data,
+			   job->item[0].size, job, sizeof(*job)))
+		return;
+	fit_plan.state[j] = FIT_VERIFY_RUNNING;
+	fit_plan.running = j;
+}
+
+/*
+ * Plan all sub-images of a configuration, @prop_name's first, followed
+ * by the order bootm loads them in, and start on the first.
+ */
+static void fit_verify_add_conf(const void *fit, int cfg_noffset,
+				const char *prop_name)
+{
+	static const char * const props[] = {
+		FIT_KERNEL_PROP, FIT_RAMDISK_PROP, FIT_FDT_PROP,
+	};
+	int noffset;
+	int i;
+
+	noffset = fit_conf_get_prop_node(fit, cfg_noffset, prop_name);
+	if (noffset >= 0)
+		fit_verify_add_image(fit, noffset);
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		noffset = fit_conf_get_prop_node(fit, cfg_noffset, props[i]);
+		if (noffset >= 0)
+			fit_verify_add_image(fit, noffset);
+	}
+	fit_verify_kick(-1);
+}
+
+/* Make sure job @j has been run, on whichever CPU gets there first */
+static void fit_verify_collect(int j)
+{
+	int k;
+
+	switch (fit_plan.state[j]) {
+	case FIT_VERIFY_RUNNING:
+		/* rather than wait idle, take on the next job meanwhile */
+		k = fit_verify_next(j);
+		if (k >= 0) {
+			fit_verify_job_run(&fit_verify_jobs[k]);
+			fit_plan.state[k] = FIT_VERIFY_DONE;
+		}
+		smp_job_wait();
+		fit_plan.running = -1;
+		break;
+	case FIT_VERIFY_PENDING:
+		fit_verify_kick(j);
+		fit_verify_job_run(&fit_verify_jobs[j]);
+		break;
+	}
+	fit_plan.state[j] = FIT_VERIFY_DONE;
+	fit_verify_kick(-1);
+}
+
+/* Get the value of hash node @noffset, if it was planned */
+static int fit_image_hash_result(const void *fit, int noffset,
+				 uint8_t *value, int *value_len)
+{
+	struct fit_hash_item *item;
+	struct fit_verify_ref *ref;
+	int i;
+
+	if (fit != fit_plan.fit)
+		return -ENOENT;
+
+	for (i = 0, ref = fit_plan.ref; i < fit_plan.nrefs; i++, ref++) {
+		if (ref->noffset != noffset)
+			continue;
+		fit_verify_collect(ref->job);
+		item = &fit_verify_jobs[ref->job].item[ref->item];
+		if (item->ret)
+			return item->ret;
+		memcpy(value, item->value, item->value_len);
+		*value_len = item->value_len;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+#else
+static inline int fit_image_hash_result(const void *fit, int noffset,
+					uint8_t *value, int *value_len)
+{
+	return -ENOENT;
+}
+#endif
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 				size_t size, char **err_msgp)
 {
@@ -901,6 +1207,7 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+	int ret;
 
 	*err_msgp = NULL;
 
@@ -924,7 +1231,10 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	ret = fit_image_hash_result(fit, noffset, value, &value_len);
+	if (ret == -ENOENT)
+		ret = calculate_hash(data, size, algo, value, &value_len);
+	if (ret) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1045,6 +1355,16 @@ int fit_all_image_verify(const void *fit)
 		return 0;
 	}
 
+#if defined(CONFIG_SMP_JOBS) && !defined(USE_HOSTCC)
+	/* Let the second CPU work ahead through the images */
+	fit_verify_reset();
+	for (noffset = fdt_first_subnode(fit, images_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset))
+		fit_verify_add_image(fit, noffset);
+	fit_verify_kick(-1);
+#endif
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
@@ -1060,8 +1380,10 @@ int fit_all_image_verify(const void *fit)
 			printf("   Hash(es) for Image %u (%s): ", count++,
 			       fit_get_name(fit, noffset, NULL));
 
-			if (!fit_image_verify(fit, noffset))
+			if (!fit_image_verify(fit, noffset)) {
+				fit_verify_reset();
 				return 0;
+			}
 			printf("\n");
 		}
 	}
@@ -1429,18 +1751,24 @@ void fit_conf_print(const void *fit, int noffset, const char *p)
 		printf("%s  FDT:          %s\n", p, uname);
 }
 
+static int fit_image_select_verify(const void *fit, int rd_noffset)
+{
+	puts("   Verifying Hash Integrity ... ");
+	if (!fit_image_verify(fit, rd_noffset)) {
+		puts("Bad Data Hash\n");
+		return -EACCES;
+	}
+	puts("OK\n");
+
+	return 0;
+}
+
 int fit_image_select(const void *fit, int rd_noffset, int verify)
 {
 	fit_image_print(fit, rd_noffset, "   ");
 
-	if (verify) {
-		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_verify(fit, rd_noffset)) {
-			puts("Bad Data Hash\n");
-			return -EACCES;
-		}
-		puts("OK\n");
-	}
+	if (verify)
+		return fit_image_select_verify(fit, rd_noffset);
 
 	return 0;
 }
@@ -1524,6 +1852,11 @@ int fit_image_load(bootm_headers_t *images, const char *prop_name, ulong addr,
 		}
 		fit_uname_config = fdt_get_name(fit, cfg_noffset, NULL);
 		printf("   Using '%s' configuration\n", fit_uname_config);
+#ifdef CONFIG_SMP_JOBS
+		/* start hashing while the configuration is checked */
+		if (images->verify)
+			fit_verify_add_conf(fit, cfg_noffset, prop_name);
+#endif
 		if (image_type == IH_TYPE_KERNEL) {
 			/* Remember (and possibly verify) this config */
 			images->fit_uname_cfg = fit_uname_config;
@@ -1552,6 +1885,13 @@ int fit_image_load(bootm_headers_t *images, const char *prop_name, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
+#ifdef CONFIG_SMP_JOBS
+	/* the second CPU may have hashed this image already */
+	if (images->verify) {
+		fit_verify_add_image(fit, noffset);
+		fit_verify_kick(-1);
+	}
+#endif
 	ret = fit_image_select(fit, noffset, images->verify);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
@@ -1648,6 +1988,11 @@ int fit_image_load(bootm_headers_t *images, const char *prop_name, ulong addr,
 		dst = map_sysmem(load, len);
 		memmove(dst, buf, len);
 		data = load;
+#ifdef CONFIG_SMP_JOBS
+		/* hashes taken ahead of the copy no longer hold */
+		if (load < image_end && load_end > image_start)
+			fit_verify_reset();
+#endif
 	}
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_LOAD);
 
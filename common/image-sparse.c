@@ -0,0 +1,323 @@
+/*
+ * Write an Android sparse image to a block device as it arrives
+ *
+ * A sparse image is a file header followed by chunks, each covering a run
+ * of output blocks: raw chunks carry the data, fill chunks a four byte
+ * value to repeat and don't care chunks nothing at all. Raw data is
+ * written from wherever the caller has it, fill chunks from one buffer
+ * that is only set up again when the value changes, and don't care
+ * chunks cost nothing, so flashing a mostly empty filesystem image takes
+ * about as long as writing the data in it.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <asm/errno.h>
+
+/* Largest single write for fill chunks */
+#define SPARSE_FILL_SIZE	(256 << 10)
+
+enum sparse_state {
+	SPARSE_HEADER,		/* collecting the file header */
+	SPARSE_CHUNK,		/* collecting a chunk header */
+	SPARSE_RAW,		/* passing raw data through */
+	SPARSE_FILL,		/* collecting the fill value */
+	SPARSE_DONE,		/* all chunks written */
+};
+
+static int sparse_put(struct sparse_stream *s, lbaint_t blkcnt,
+		      const void *buf)
+{
+	struct sparse_storage *info = s->info;
+
+	if (info->write(info, info->start + s->blk, blkcnt, buf) != blkcnt) {
+		printf("sparse: write failed at block " LBAF "\n",
+		       info->start + s->blk);
+		return -EIO;
+	}
+	s->blk += blkcnt;
+	s->written += blkcnt;
+
+	return 0;
+}
+
+static void sparse_next_chunk(struct sparse_stream *s)
+{
+	if (!--s->chunks_left) {
+		s->state = SPARSE_DONE;
+		return;
+	}
+	s->state = SPARSE_CHUNK;
+	s->need = sizeof(chunk_header_t);
+}
+
+static int sparse_header(struct sparse_stream *s)
+{
+	sparse_header_t *hdr = &s->hdr;
+	lbaint_t blksz = s->info->blksz;
+
+	hdr->magic = get_unaligned_le32(s->stage);
+	hdr->major_version = get_unaligned_le16(s->stage + 4);
+	hdr->minor_version = get_unaligned_le16(s->stage + 6);
+	hdr->file_hdr_sz = get_unaligned_le16(s->stage + 8);
+	hdr->chunk_hdr_sz = get_unaligned_le16(s->stage + 10);
+	hdr->blk_sz = get_unaligned_le32(s->stage + 12);
+	hdr->total_blks = get_unaligned_le32(s->stage + 16);
+	hdr->total_chunks = get_unaligned_le32(s->stage + 20);
+	hdr->image_checksum = get_unaligned_le32(s->stage + 24);
+
+	if (hdr->magic != SPARSE_HEADER_MAGIC ||
+	    hdr->major_version != SPARSE_HEADER_MAJOR_VER ||
+	    hdr->file_hdr_sz < sizeof(sparse_header_t) ||
+	    hdr->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		printf("sparse: bad image header\n");
+		return -EINVAL;
+	}
+	if (!hdr->blk_sz || hdr->blk_sz % blksz) {
+		printf("sparse: block size %u is not a multiple of " LBAFU "\n",
+		       hdr->blk_sz, blksz);
+		return -EINVAL;
+	}
+	if ((u64)hdr->total_blks * (hdr->blk_sz / blksz) > s->info->size) {
+		printf("sparse: image of %u blocks does not fit in " LBAFU
+		       " blocks\n", hdr->total_blks, s->info->size);
+		return -ENOSPC;
+	}
+
+	s->part = memalign(ARCH_DMA_MINALIGN, blksz);
+	if (!s->part)
+		return -ENOMEM;
+	s->skip = hdr->file_hdr_sz - sizeof(sparse_header_t);
+	s->chunks_left = hdr->total_chunks + 1;
+	sparse_next_chunk(s);
+
+	return 0;
+}
+
+static int sparse_chunk(struct sparse_stream *s)
+{
+	u32 ratio = s->hdr.blk_sz / s->info->blksz;
+	u32 type = get_unaligned_le16(s->stage);
+	u32 chunk_sz = get_unaligned_le32(s->stage + 4);
+	u32 total_sz = get_unaligned_le32(s->stage + 8);
+	u64 blks = (u64)chunk_sz * ratio;
+	u64 data;
+
+	if (total_sz < s->hdr.chunk_hdr_sz)
+		goto bad;
+	data = total_sz - s->hdr.chunk_hdr_sz;
+	s->skip = s->hdr.chunk_hdr_sz - sizeof(chunk_header_t);
+	if (type != CHUNK_TYPE_CRC32 &&
+	    s->blk + blks > (u64)s->hdr.total_blks * ratio) {
+		printf("sparse: chunk runs past the end of the image\n");
+		return -EINVAL;
+	}
+	s->chunk_blks = blks;
+
+	switch (type) {
+	case CHUNK_TYPE_RAW:
+		if (data != (u64)chunk_sz * s->hdr.blk_sz)
+			goto bad;
+		s->left = data;
+		s->state = SPARSE_RAW;
+		if (!s->left)
+			sparse_next_chunk(s);
+		break;
+	case CHUNK_TYPE_FILL:
+		if (data != sizeof(u32))
+			goto bad;
+		s->state = SPARSE_FILL;
+		s->need = sizeof(u32);
+		break;
+	case CHUNK_TYPE_DONT_CARE:
+		if (data)
+			goto bad;
+		s->blk += blks;
+		s->skipped += blks;
+		sparse_next_chunk(s);
+		break;
+	case CHUNK_TYPE_CRC32:
+		/* The value covers the output written so far; not checked */
+		s->skip += data;
+		sparse_next_chunk(s);
+		break;
+	default:
+		printf("sparse: unknown chunk type %#x\n", type);
+		return -EINVAL;
+	}
+
+	return 0;
+
+bad:
+	printf("sparse: bad header for chunk type %#x\n", type);
+	return -EINVAL;
+}
+
+static int sparse_fill(struct sparse_stream *s)
+{
+	lbaint_t blksz = s->info->blksz;
+	u32 val = get_unaligned_le32(s->stage);
+	lbaint_t blks = s->chunk_blks;
+	lbaint_t n;
+	u32 *p;
+	int i, ret;
+
+	if (!s->fill) {
+		s->fill_blks = SPARSE_FILL_SIZE / blksz;
+		if (!s->fill_blks)
+			s->fill_blks = 1;
+		s->fill = memalign(ARCH_DMA_MINALIGN, s->fill_blks * blksz);
+		if (!s->fill)
+			return -ENOMEM;
+		s->fill_val = ~val;
+	}
+	if (s->fill_val != val) {
+		p = (u32 *)s->fill;
+		for (i = s->fill_blks * blksz / sizeof(u32); i; i--)
+			*p++ = val;
+		s->fill_val = val;
+	}
+
+	while (blks) {
+		n = min(blks, s->fill_blks);
+		ret = sparse_put(s, n, s->fill);
+		if (ret)
+			return ret;
+		blks -= n;
+	}
+	sparse_next_chunk(s);
+
+	return 0;
+}
+
+/* Pass up to @len bytes of raw chunk data through; returns bytes used */
+static long sparse_raw(struct sparse_stream *s, const u8 *p, ulong len)
+{
+	lbaint_t blksz = s->info->blksz;
+	ulong used, n;
+	lbaint_t blks;
+	int ret;
+
+	len = min(len, s->left);
+	used = 0;
+
+	/* Finish a block started by the last call */
+	if (s->part_len) {
+		n = min(len, (ulong)(blksz - s->part_len));
+		memcpy(s->part + s->part_len, p, n);
+		s->part_len += n;
+		used += n;
+		if (s->part_len == blksz) {
+			ret = sparse_put(s, 1, s->part);
+			if (ret)
+				return ret;
+			s->part_len = 0;
+		}
+	}
+
+	/* Whole blocks go straight from the caller's buffer */
+	blks = (len - used) / blksz;
+	if (blks) {
+		ret = sparse_put(s, blks, p + used);
+		if (ret)
+			return ret;
+		used += blks * blksz;
+	}
+
+	/* Keep the start of the next block */
+	if (used < len) {
+		n = len - used;
+		memcpy(s->part + s->part_len, p + used, n);
+		s->part_len += n;
+		used += n;
+	}
+
+	s->left -= used;
+	if (!s->left)
+		sparse_next_chunk(s);
+
+	return used;
+}
+
+void sparse_stream_start(struct sparse_stream *s, struct sparse_storage *info)
+{
+	memset(s, 0, sizeof(*s));
+	s->info = info;
+	s->state = SPARSE_HEADER;
+	s->need = sizeof(sparse_header_t);
+}
+
+int sparse_stream_write(struct sparse_stream *s, const void *data, ulong len)
+{
+	const u8 *p = data;
+	ulong n;
+	long used;
+	int ret;
+
+	while (len && !s->err && s->state != SPARSE_DONE) {
+		if (s->skip) {
+			n = min(len, s->skip);
+			s->skip -= n;
+			p += n;
+			len -= n;
+			continue;
+		}
+
+		if (s->state == SPARSE_RAW) {
+			used = sparse_raw(s, p, len);
+			if (used < 0) {
+				s->err = used;
+				break;
+			}
+			p += used;
+			len -= used;
+			continue;
+		}
+
+		/* Headers and fill values may be split across calls */
+		n = min(len, (ulong)(s->need - s->staged));
+		memcpy(s->stage + s->staged, p, n);
+		s->staged += n;
+		p += n;
+		len -= n;
+		if (s->staged < s->need)
+			break;
+		s->staged = 0;
+
+		switch (s->state) {
+		case SPARSE_HEADER:
+			ret = sparse_header(s);
+			break;
+		case SPARSE_CHUNK:
+			ret = sparse_chunk(s);
+			break;
+		default:
+			ret = sparse_fill(s);
+			break;
+		}
+		if (ret)
+			s->err = ret;
+	}
+
+	return s->err;
+}
+
+int sparse_stream_finish(struct sparse_stream *s)
+{
+	free(s->part);
+	free(s->fill);
+	s->part = NULL;
+	s->fill = NULL;
+
+	if (s->err)
+		return s->err;
+	if (s->state != SPARSE_DONE) {
+		printf("sparse: image is incomplete\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
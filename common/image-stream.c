@@ -0,0 +1,216 @@
+/*
+ * Uncompress a legacy gzip kernel image while it is being loaded
+ *
+ * Loaders (tftp, the generic 'load' command) report each piece of a file
+ * as it lands in memory. If the file is a gzip compressed kernel uImage,
+ * its payload is inflated to the image load address right away, so the
+ * work is done between network packets rather than in one pass at bootm
+ * time. bootm then finds the kernel already in place and skips
+ * decompression. The compressed file itself is still stored in full at
+ * the address the loader was given; only the separate decompression
+ * pass at bootm time goes away.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <image.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
+#include <u-boot/zlib.h>
+#include <asm/errno.h>
+#include <asm/io.h>
+#include <asm/unaligned.h>
+
+#ifndef CONFIG_SYS_BOOTM_LEN
+#define CONFIG_SYS_BOOTM_LEN	0x800000	/* as in cmd_bootm.c */
+#endif
+
+enum stream_state {
+	STREAM_OFF,		/* not a streamable image, or gave up */
+	STREAM_HEADER,		/* waiting for the uImage and gzip headers */
+	STREAM_INFLATE,		/* inflating the payload */
+	STREAM_DONE,		/* kernel in place, waiting for bootm */
+};
+
+static enum stream_state state;
+static ulong stream_addr;	/* where the file is being stored */
+static ulong stream_avail;	/* bytes of it in memory so far */
+static ulong stream_used;	/* bytes of payload handed to inflate() */
+static ulong stream_out;	/* uncompressed length once done */
+static image_header_t stream_hdr;
+static z_stream stream_z;
+
+static void stream_stop(void)
+{
+	if (state == STREAM_INFLATE)
+		inflateEnd(&stream_z);
+	state = STREAM_OFF;
+}
+
+/*
+ * Check the uImage header and set up inflate() once the gzip header is in.
+ * Returns 1 to wait for more data, 0 when set up, -1 to give up.
+ */
+static int stream_setup(void)
+{
+	const image_header_t *hdr = map_sysmem(stream_addr, 0);
+	ulong hlen = sizeof(image_header_t);
+	ulong load, len, end, max;
+	int ret;
+
+	if (stream_avail < hlen)
+		return 1;
+	if (!image_check_magic(hdr) || !image_check_hcrc(hdr) ||
+	    !image_check_type(hdr, IH_TYPE_KERNEL) ||
+	    image_get_comp(hdr) != IH_COMP_GZIP)
+		return -1;
+
+	/* Only write where bootm would, and never over the file itself */
+	load = image_get_load(hdr);
+	len = image_get_data_size(hdr);
+	end = stream_addr + hlen + len;
+	max = CONFIG_SYS_BOOTM_LEN;
+	if (load < stream_addr)
+		max = min(max, stream_addr - load);
+	else if (load < end)
+		return -1;
+
+	/* stream_avail counts bytes from stream_addr, end is an address */
+	ret = gzip_parse_header(map_sysmem(stream_addr + hlen, 0),
+				min(stream_avail, hlen + len) - hlen);
+	if (ret == -EAGAIN && stream_avail < hlen + len)
+		return 1;
+	if (ret < 0)
+		return -1;
+
+	memset(&stream_z, 0, sizeof(stream_z));
+	stream_z.zalloc = gzalloc;
+	stream_z.zfree = gzfree;
+	if (inflateInit2(&stream_z, -MAX_WBITS) != Z_OK)
+		return -1;
+	stream_z.next_out = map_sysmem(load, max);
+	stream_z.avail_out = max;
+	stream_used = ret;
+	memcpy(&stream_hdr, hdr, hlen);
+
+	return 0;
+}
+
+/* Feed inflate() whatever has arrived since the last call */
+static void stream_run(void)
+{
+	ulong hlen = sizeof(image_header_t);
+	ulong len, avail;
+	int ret;
+
+	if (state == STREAM_HEADER) {
+		ret = stream_setup();
+		if (ret > 0)
+			return;
+		if (ret < 0) {
+			state = STREAM_OFF;
+			return;
+		}
+		state = STREAM_INFLATE;
+	}
+	if (state != STREAM_INFLATE)
+		return;
+
+	len = image_get_data_size(&stream_hdr);
+	avail = min(stream_avail - hlen, len);
+	if (avail <= stream_used)
+		return;
+	stream_z.next_in = map_sysmem(stream_addr + hlen + stream_used, 0);
+	stream_z.avail_in = avail - stream_used;
+	ret = inflate(&stream_z, Z_NO_FLUSH);
+	stream_used = avail - stream_z.avail_in;
+	if (ret == Z_STREAM_END) {
+		stream_out = stream_z.total_out;
+		inflateEnd(&stream_z);
+		flush_cache(image_get_load(&stream_hdr), stream_out);
+		state = STREAM_DONE;
+	} else if (ret != Z_OK) {
+		debug("image stream: inflate() returned %d\n", ret);
+		stream_stop();
+	}
+}
+
+void image_stream_start(ulong addr)
+{
+	stream_stop();
+	if (getenv_yesno("loadunzip") != 1)
+		return;
+
+	stream_addr = addr;
+	stream_avail = 0;
+	state = STREAM_HEADER;
+}
+
+void image_stream_update(ulong offset, const void *buf, ulong len)
+{
+	if (state != STREAM_HEADER && state != STREAM_INFLATE)
+		return;
+
+	/* The file must arrive in order; anything else is left to bootm */
+	if (offset > stream_avail) {
+		stream_stop();
+		return;
+	}
+	if (offset + len > stream_avail) {
+		stream_avail = offset + len;
+		stream_run();
+	}
+}
+
+int image_stream_busy(void)
+{
+	return state == STREAM_HEADER || state == STREAM_INFLATE;
+}
+
+void image_stream_finish(ulong len)
+{
+	if (state == STREAM_OFF)
+		return;
+
+	stream_avail = len;
+	stream_run();
+	if (state != STREAM_DONE) {
+		stream_stop();
+		return;
+	}
+	printf("Uncompressed %s to %08x, %lu bytes\n",
+	       genimg_get_type_name(image_get_type(&stream_hdr)),
+	       image_get_load(&stream_hdr), stream_out);
+}
+
+int image_stream_take(const image_header_t *hdr, ulong *lenp)
+{
+	const uchar *trailer;
+	ulong load, crc;
+
+	if (state != STREAM_DONE ||
+	    map_to_sysmem(hdr) != stream_addr ||
+	    memcmp(hdr, &stream_hdr, sizeof(stream_hdr)))
+		return 0;
+
+	/* Good for one boot; the memory may be reused after that */
+	state = STREAM_OFF;
+
+	/*
+	 * Something may have been loaded over the kernel since, so check
+	 * it against the CRC in the gzip trailer before using it.
+	 */
+	trailer = (const uchar *)image_get_data(hdr) + stream_used;
+	if (stream_used + 8 > image_get_data_size(hdr))
+		return 0;
+	load = image_get_load(hdr);
+	crc = crc32_wd(0, map_sysmem(load, stream_out), stream_out,
+		       CHUNKSZ_CRC32);
+	if (crc != get_unaligned_le32(trailer))
+		return 0;
+
+	*lenp = stream_out;
+
+	return 1;
+}
@@ -13,6 +13,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <environment.h>
 #include <fdtdec.h>
 #include <hush.h>
 #include <malloc.h>
@@ -396,7 +397,10 @@ static void process_boot_delay(void)
 		int prev = disable_ctrlc(1);	/* disable Control C checking */
 #endif
 
+		/* bootcmd is one script as far as saveenv is concerned */
+		env_save_hold();
 		run_command_list(s, -1, 0);
+		env_save_release();
 
 #if defined(CONFIG_AUTOBOOT_KEYED) && !defined(CONFIG_AUTOBOOT_KEYED_CTRLC)
 		disable_ctrlc(prev);	/* restore Control C checking */
@@ -459,7 +463,9 @@ void main_loop(void)
 		int prev = disable_ctrlc(1);	/* disable Control C checking */
 # endif
 
+		env_save_hold();
 		run_command_list(p, -1, 0);
+		env_save_release();
 
 # ifdef CONFIG_AUTOBOOT_KEYED
 		disable_ctrlc(prev);	/* restore Control C checking */
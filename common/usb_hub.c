@@ -24,6 +24,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <watchdog.h>
 #include <asm/processor.h>
 #include <asm/unaligned.h>
 #include <linux/ctype.h>
@@ -44,6 +45,31 @@
 static struct usb_hub_device hub_dev[USB_MAX_HUB];
 static int usb_hub_index;
 
+#define PORT_DEBOUNCE_DELAY	200
+#define PORT_RECOVERY_DELAY	200
+
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+/*
+ * The ports of all hubs are brought up together by a state machine, so
+ * that one port waits for its power, connection or debounce delay while
+ * the others get on with theirs. Only the reset and enumeration of a
+ * device are done one at a time, since it answers at address 0 until it
+ * has been given its own.
+ */
+enum usb_port_state {
+	PORT_POWER_OFF,		/* power-cycling, waiting to switch it on */
+	PORT_POWER_ON,		/* waiting for the power to be good */
+	PORT_CONNECT,		/* waiting for the connection to settle */
+	PORT_DEBOUNCE,		/* connected, waiting to reset the device */
+	PORT_RECOVERY,		/* reset, waiting to enumerate the device */
+	PORT_DONE,
+};
+
+static int usb_hub_scanning;
+static struct usb_hub_device *addr0_hub;	/* hub of the port at address 0 */
+static int addr0_port;
+#endif
+
 __weak void usb_hub_reset_devices(int port)
 {
 	return;
@@ -85,6 +111,34 @@ static int usb_get_port_status(struct usb_device *dev, int port, void *data)
 }
 
 
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+static void usb_hub_power_on(struct usb_hub_device *hub)
+{
+	int i;
+	struct usb_device *dev;
+
+	dev = hub->pusb_dev;
+
+	/*
+	 * Enable power to the ports:
+	 * Here we Power-cycle the ports: aka,
+	 * turning them off and turning on again.
+	 * usb_hub_port_step() switches them on again once the power
+	 * is off. Ports that are done are left alone.
+	 */
+	debug("enabling power on all ports\n");
+	for (i = 0; i < dev->maxchild; i++) {
+		if (hub->port_state[i] == PORT_DONE)
+			continue;
+		usb_clear_port_feature(dev, i + 1, USB_PORT_FEAT_POWER);
+		debug("port %d returns %lX\n", i + 1, dev->status);
+		if (addr0_hub == hub && addr0_port == i)
+			addr0_hub = NULL;
+		hub->port_state[i] = PORT_POWER_OFF;
+		hub->port_timer[i] = get_timer(0);
+	}
+}
+#else
 static void usb_hub_power_on(struct usb_hub_device *hub)
 {
 	int i;
@@ -141,6 +195,7 @@ static void usb_hub_power_on(struct usb_hub_device *hub)
 	/* Wait for power to become stable */
 	mdelay(max(pgood_delay, CONFIG_USB_HUB_MIN_POWER_ON_DELAY));
 }
+#endif
 
 void usb_hub_reset(void)
 {
@@ -233,16 +288,16 @@ int hub_port_reset(struct usb_device *dev, int port,
 }
 
 
-void usb_hub_port_connect_change(struct usb_device *dev, int port)
+/* Acknowledge a connection change; returns 1 if a device is connected */
+static int hub_port_connected(struct usb_device *dev, int port)
 {
-	struct usb_device *usb;
 	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
 	unsigned short portstatus;
 
 	/* Check status */
 	if (usb_get_port_status(dev, port + 1, portsts) < 0) {
 		debug("get_port_status failed\n");
-		return;
+		return 0;
 	}
 
 	portstatus = le16_to_cpu(portsts->wPortStatus);
@@ -260,17 +315,17 @@ void usb_hub_port_connect_change(struct usb_device *dev, int port)
 		debug("usb_disconnect(&hub->children[port]);\n");
 		/* Return now if nothing is connected */
 		if (!(portstatus & USB_PORT_STAT_CONNECTION))
-			return;
+			return 0;
 	}
-	mdelay(200);
 
-	/* Reset the port */
-	if (hub_port_reset(dev, port, &portstatus) < 0) {
-		printf("cannot reset port %i!?\n", port + 1);
-		return;
-	}
+	return 1;
+}
 
-	mdelay(200);
+/* Set up the device on a port that has just been reset */
+static void hub_port_enumerate(struct usb_device *dev, int port,
+			       unsigned short portstatus)
+{
+	struct usb_device *usb;
 
 	/* Allocate a new device struct for it */
 	usb = usb_alloc_new_device(dev->controller);
@@ -303,6 +358,237 @@ void usb_hub_port_connect_change(struct usb_device *dev, int port)
 	}
 }
 
+void usb_hub_port_connect_change(struct usb_device *dev, int port)
+{
+	unsigned short portstatus;
+
+	if (!hub_port_connected(dev, port))
+		return;
+	mdelay(PORT_DEBOUNCE_DELAY);
+
+	/* Reset the port */
+	if (hub_port_reset(dev, port, &portstatus) < 0) {
+		printf("cannot reset port %i!?\n", port + 1);
+		return;
+	}
+
+	mdelay(PORT_RECOVERY_DELAY);
+	hub_port_enumerate(dev, port, portstatus);
+}
+
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+/* Note when each device is ready, for 'bootstage report' */
+static void usb_hub_mark(struct usb_device *dev, int port)
+{
+#ifdef CONFIG_BOOTSTAGE
+	static char name[USB_MAX_DEVICE][16];
+	struct usb_device *usb = dev->children[port];
+
+	if (!usb || usb->devnum < 1 || usb->devnum > USB_MAX_DEVICE)
+		return;
+	snprintf(name[usb->devnum - 1], sizeof(name[0]), "usb %d-%d",
+		 dev->devnum, port + 1);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, name[usb->devnum - 1]);
+#endif
+}
+
+/* Handle the port status once the connection state has settled */
+static void usb_hub_port_status(struct usb_hub_device *hub, int i,
+				unsigned short portstatus,
+				unsigned short portchange)
+{
+	struct usb_device *dev = hub->pusb_dev;
+
+	debug("Port %d Status %X Change %X\n",
+	      i + 1, portstatus, portchange);
+
+	hub->port_state[i] = PORT_DONE;
+	if (portchange & USB_PORT_STAT_C_CONNECTION) {
+		debug("port %d connection change\n", i + 1);
+		if (hub_port_connected(dev, i)) {
+			hub->port_state[i] = PORT_DEBOUNCE;
+			hub->port_timer[i] = get_timer(0);
+		}
+	}
+	if (portchange & USB_PORT_STAT_C_ENABLE) {
+		debug("port %d enable change, status %x\n",
+		      i + 1, portstatus);
+		usb_clear_port_feature(dev, i + 1,
+					USB_PORT_FEAT_C_ENABLE);
+		/*
+		 * The following hack causes a ghost device problem
+		 * to Faraday EHCI
+		 */
+#ifndef CONFIG_USB_EHCI_FARADAY
+		/* EM interference sometimes causes bad shielded USB
+		 * devices to be shutdown by the hub, this hack enables
+		 * them again. Works at least with mouse driver */
+		if (!(portstatus & USB_PORT_STAT_ENABLE) &&
+		     (portstatus & USB_PORT_STAT_CONNECTION) &&
+		     ((dev->children[i]))) {
+			debug("already running port %i "  \
+			      "disabled by hub (EMI?), " \
+			      "re-enabling...\n", i + 1);
+			      usb_hub_port_connect_change(dev, i);
+		}
+#endif
+	}
+	if (portstatus & USB_PORT_STAT_SUSPEND) {
+		debug("port %d suspend change\n", i + 1);
+		usb_clear_port_feature(dev, i + 1,
+					USB_PORT_FEAT_SUSPEND);
+	}
+
+	if (portchange & USB_PORT_STAT_C_OVERCURRENT) {
+		debug("port %d over-current change\n", i + 1);
+		usb_clear_port_feature(dev, i + 1,
+					USB_PORT_FEAT_C_OVER_CURRENT);
+		/* Give up on this port, start again with the others */
+		hub->port_state[i] = PORT_DONE;
+		usb_hub_power_on(hub);
+	}
+
+	if (portchange & USB_PORT_STAT_C_RESET) {
+		debug("port %d reset change\n", i + 1);
+		usb_clear_port_feature(dev, i + 1,
+					USB_PORT_FEAT_C_RESET);
+	}
+}
+
+/* Move a port on to its next state once the current one is over */
+static void usb_hub_port_step(struct usb_hub_device *hub, int i)
+{
+	struct usb_device *dev = hub->pusb_dev;
+	unsigned pgood_delay = hub->desc.bPwrOn2PwrGood * 2;
+	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
+	unsigned short portstatus, portchange;
+	ulong elapsed = get_timer(hub->port_timer[i]);
+
+	switch (hub->port_state[i]) {
+	case PORT_POWER_OFF:
+		/* Wait at least 2*bPwrOn2PwrGood for PP to change */
+		if (elapsed < pgood_delay)
+			break;
+
+		/*
+		 * Check to confirm the state of Port Power:
+		 * xHCI says "After modifying PP, s/w shall read
+		 * PP and confirm that it has reached the desired state
+		 * before modifying it again, undefined behavior may occur
+		 * if this procedure is not followed".
+		 * EHCI doesn't say anything like this, but no harm in keeping
+		 * this.
+		 */
+		if (usb_get_port_status(dev, i + 1, portsts) < 0) {
+			debug("port %d: get_port_status failed\n", i + 1);
+		} else {
+			portstatus = le16_to_cpu(portsts->wPortStatus);
+			if (portstatus & (USB_PORT_STAT_POWER << 1))
+				debug("port %d: Port power change failed\n",
+				      i + 1);
+		}
+
+		usb_set_port_feature(dev, i + 1, USB_PORT_FEAT_POWER);
+		debug("port %d returns %lX\n", i + 1, dev->status);
+		hub->port_state[i] = PORT_POWER_ON;
+		hub->port_timer[i] = get_timer(0);
+		break;
+
+	case PORT_POWER_ON:
+		/* Wait for power to become stable */
+		if (elapsed < max(pgood_delay,
+				  (unsigned)CONFIG_USB_HUB_MIN_POWER_ON_DELAY))
+			break;
+
+		/*
+		 * Reset any devices that may be in a bad state when applying
+		 * the power.  This is a __weak function.  Resetting of the
+		 * devices should occur in the board file of the device.
+		 */
+		usb_hub_reset_devices(i + 1);
+		hub->port_state[i] = PORT_CONNECT;
+		hub->port_timer[i] = get_timer(0);
+		break;
+
+	case PORT_CONNECT:
+		if (usb_get_port_status(dev, i + 1, portsts) < 0) {
+			debug("get_port_status failed\n");
+			hub->port_state[i] = PORT_DONE;
+			break;
+		}
+		portstatus = le16_to_cpu(portsts->wPortStatus);
+		portchange = le16_to_cpu(portsts->wPortChange);
+
+		/*
+		 * Wait for (whichever finishes first)
+		 *  - A maximum of 10 seconds
+		 *    This is a purely observational value driven by connecting
+		 *    a few broken pen drives and taking the max * 1.5 approach
+		 *  - connection_change and connection state to report same
+		 *    state
+		 */
+		if ((portchange & USB_PORT_STAT_C_CONNECTION) !=
+		    (portstatus & USB_PORT_STAT_CONNECTION) &&
+		    elapsed < CONFIG_SYS_HZ * 10)
+			break;
+
+		usb_hub_port_status(hub, i, portstatus, portchange);
+		break;
+
+	case PORT_DEBOUNCE:
+		if (elapsed < PORT_DEBOUNCE_DELAY || addr0_hub)
+			break;
+
+		/* Reset the port */
+		if (hub_port_reset(dev, i, &hub->port_status[i]) < 0) {
+			printf("cannot reset port %i!?\n", i + 1);
+			hub->port_state[i] = PORT_DONE;
+			break;
+		}
+		addr0_hub = hub;
+		addr0_port = i;
+		hub->port_state[i] = PORT_RECOVERY;
+		hub->port_timer[i] = get_timer(0);
+		break;
+
+	case PORT_RECOVERY:
+		if (elapsed < PORT_RECOVERY_DELAY)
+			break;
+
+		hub->port_state[i] = PORT_DONE;
+		hub_port_enumerate(dev, i, hub->port_status[i]);
+		addr0_hub = NULL;
+		usb_hub_mark(dev, i);
+		break;
+	}
+}
+
+/*
+ * Step through the ports of all hubs until every one is done. Hubs found
+ * on the way are configured from usb_new_device(), which puts their ports
+ * into the same loop.
+ */
+static void usb_hub_scan(void)
+{
+	struct usb_hub_device *hub;
+	int h, i, busy;
+
+	do {
+		busy = 0;
+		for (h = 0; h < usb_hub_index; h++) {
+			hub = &hub_dev[h];
+			for (i = 0; i < hub->pusb_dev->maxchild; i++) {
+				if (hub->port_state[i] == PORT_DONE)
+					continue;
+				usb_hub_port_step(hub, i);
+				busy = 1;
+			}
+		}
+		WATCHDOG_RESET();
+	} while (busy);
+}
+#endif /* CONFIG_USB_HUB_CONCURRENT_SCAN */
+
 
 static int usb_hub_configure(struct usb_device *dev)
 {
@@ -319,6 +605,10 @@ static int usb_hub_configure(struct usb_device *dev)
 	if (hub == NULL)
 		return -1;
 	hub->pusb_dev = dev;
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+	for (i = 0; i < USB_MAXCHILDREN; i++)
+		hub->port_state[i] = PORT_DONE;
+#endif
 	/* Get the the hub descriptor */
 	if (usb_get_hub_descriptor(dev, buffer, 4) < 0) {
 		debug("usb_hub_configure: failed to get hub " \
@@ -354,6 +644,12 @@ static int usb_hub_configure(struct usb_device *dev)
 
 	dev->maxchild = descriptor->bNbrPorts;
 	debug("%d ports detected\n", dev->maxchild);
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+	if (dev->maxchild > USB_MAXCHILDREN) {
+		debug("using only the first %d ports\n", USB_MAXCHILDREN);
+		dev->maxchild = USB_MAXCHILDREN;
+	}
+#endif
 
 	hubCharacteristics = get_unaligned(&hub->desc.wHubCharacteristics);
 	switch (hubCharacteristics & HUB_CHAR_LPSM) {
@@ -422,6 +718,18 @@ static int usb_hub_configure(struct usb_device *dev)
 	debug("%sover-current condition exists\n",
 	      (le16_to_cpu(hubsts->wHubStatus) & HUB_STATUS_OVERCURRENT) ? \
 	      "" : "no ");
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+	for (i = 0; i < dev->maxchild; i++)
+		hub->port_state[i] = PORT_POWER_OFF;
+	usb_hub_power_on(hub);
+
+	/* A hub found during a scan is taken care of by that scan */
+	if (!usb_hub_scanning) {
+		usb_hub_scanning = 1;
+		usb_hub_scan();
+		usb_hub_scanning = 0;
+	}
+#else
 	usb_hub_power_on(hub);
 
 	/*
@@ -514,6 +822,7 @@ static int usb_hub_configure(struct usb_device *dev)
 						USB_PORT_FEAT_C_RESET);
 		}
 	} /* end for i all ports */
+#endif
 
 	return 0;
 }
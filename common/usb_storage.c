@@ -472,6 +472,22 @@ static int usb_stor_CB_reset(struct us_data *us)
 	return 0;
 }
 
+/* Fill in the CBW for a command */
+static void usb_stor_BBB_cbw(ccb *srb, umass_bbb_cbw_t *cbw)
+{
+	int dir_in = US_DIRECTION(srb->cmd[0]);
+
+	cbw->dCBWSignature = cpu_to_le32(CBWSIGNATURE);
+	cbw->dCBWTag = cpu_to_le32(CBWTag++);
+	cbw->dCBWDataTransferLength = cpu_to_le32(srb->datalen);
+	cbw->bCBWFlags = (dir_in ? CBWFLAGS_IN : CBWFLAGS_OUT);
+	cbw->bCBWLUN = srb->lun;
+	cbw->bCDBLength = srb->cmdlen;
+	/* copy the command data into the CBW command data buffer */
+	/* DST SRC LEN!!! */
+	memcpy(cbw->CBWCDB, srb->cmd, srb->cmdlen);
+}
+
 /*
  * Set up the command for a BBB device. Note that the actual SCSI
  * command is copied into cbw.CBWCDB.
@@ -480,15 +496,12 @@ static int usb_stor_BBB_comdat(ccb *srb, struct us_data *us)
 {
 	int result;
 	int actlen;
-	int dir_in;
 	unsigned int pipe;
 	ALLOC_CACHE_ALIGN_BUFFER(umass_bbb_cbw_t, cbw, 1);
 
-	dir_in = US_DIRECTION(srb->cmd[0]);
-
 #ifdef BBB_COMDAT_TRACE
 	printf("dir %d lun %d cmdlen %d cmd %p datalen %lu pdata %p\n",
-		dir_in, srb->lun, srb->cmdlen, srb->cmd, srb->datalen,
+		US_DIRECTION(srb->cmd[0]), srb->lun, srb->cmdlen, srb->cmd, srb->datalen,
 		srb->pdata);
 	if (srb->cmdlen) {
 		for (result = 0; result < srb->cmdlen; result++)
@@ -505,15 +518,7 @@ static int usb_stor_BBB_comdat(ccb *srb, struct us_data *us)
 	/* always OUT to the ep */
 	pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 
-	cbw->dCBWSignature = cpu_to_le32(CBWSIGNATURE);
-	cbw->dCBWTag = cpu_to_le32(CBWTag++);
-	cbw->dCBWDataTransferLength = cpu_to_le32(srb->datalen);
-	cbw->bCBWFlags = (dir_in ? CBWFLAGS_IN : CBWFLAGS_OUT);
-	cbw->bCBWLUN = srb->lun;
-	cbw->bCDBLength = srb->cmdlen;
-	/* copy the command data into the CBW command data buffer */
-	/* DST SRC LEN!!! */
-	memcpy(cbw->CBWCDB, srb->cmd, srb->cmdlen);
+	usb_stor_BBB_cbw(srb, cbw);
 	result = usb_bulk_msg(us->pusb_dev, pipe, cbw, UMASS_BBB_CBW_SIZE,
 			      &actlen, USB_CNTL_TIMEOUT * 5);
 	if (result < 0)
@@ -651,6 +656,105 @@ static int usb_stor_BBB_clear_endpt_stall(struct us_data *us, __u8 endpt)
 	return result;
 }
 
+/* Check the CSW of a command */
+static int usb_stor_BBB_status(ccb *srb, struct us_data *us,
+			       umass_bbb_csw_t *csw, int data_actlen)
+{
+	unsigned int pipe;
+
+	/* misuse pipe to get the residue */
+	pipe = le32_to_cpu(csw->dCSWDataResidue);
+	if (pipe == 0 && srb->datalen != 0 && srb->datalen - data_actlen != 0)
+		pipe = srb->datalen - data_actlen;
+	if (CSWSIGNATURE != le32_to_cpu(csw->dCSWSignature)) {
+		debug("!CSWSIGNATURE\n");
+		usb_stor_BBB_reset(us);
+		return USB_STOR_TRANSPORT_FAILED;
+	} else if ((CBWTag - 1) != le32_to_cpu(csw->dCSWTag)) {
+		debug("!Tag\n");
+		usb_stor_BBB_reset(us);
+		return USB_STOR_TRANSPORT_FAILED;
+	} else if (csw->bCSWStatus > CSWSTATUS_PHASE) {
+		debug(">PHASE\n");
+		usb_stor_BBB_reset(us);
+		return USB_STOR_TRANSPORT_FAILED;
+	} else if (csw->bCSWStatus == CSWSTATUS_PHASE) {
+		debug("=PHASE\n");
+		usb_stor_BBB_reset(us);
+		return USB_STOR_TRANSPORT_FAILED;
+	} else if (data_actlen > srb->datalen) {
+		debug("transferred %dB instead of %ldB\n",
+		      data_actlen, srb->datalen);
+		return USB_STOR_TRANSPORT_FAILED;
+	} else if (csw->bCSWStatus == CSWSTATUS_FAILED) {
+		debug("FAILED\n");
+		return USB_STOR_TRANSPORT_FAILED;
+	}
+
+	return USB_STOR_TRANSPORT_GOOD;
+}
+
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+#define BBB_QUEUE_DONE		0	/* CSW read */
+#define BBB_QUEUE_COMMAND	1	/* sending the CBW failed */
+#define BBB_QUEUE_DATA		2	/* DATA phase failed */
+#define BBB_QUEUE_STATUS	3	/* CSW still to be read */
+#define BBB_QUEUE_NONE		4	/* nothing sent */
+
+/*
+ * Queue the CBW, the data and, for reads, the CSW at once, so that the
+ * host controller goes from one phase to the next without waiting for us.
+ * The IN transfers are queued first; the device NAKs them until it has
+ * seen the CBW. Writes read the CSW step by step, as the device may only
+ * answer once a stalled DATA phase has been cleared.
+ */
+static int usb_stor_BBB_queue(ccb *srb, struct us_data *us,
+			      umass_bbb_csw_t *csw, int *data_actlen)
+{
+	struct usb_device *dev = us->pusb_dev;
+	unsigned int pipein = usb_rcvbulkpipe(dev, us->ep_in);
+	unsigned int pipeout = usb_sndbulkpipe(dev, us->ep_out);
+	int dir_in = US_DIRECTION(srb->cmd[0]);
+	struct bulk_req req[3];		/* CBW, DATA, CSW */
+	ALLOC_CACHE_ALIGN_BUFFER(umass_bbb_cbw_t, cbw, 1);
+
+	if (srb->cmdlen > CBWCDBLENGTH)
+		return BBB_QUEUE_NONE;
+
+	usb_stor_BBB_cbw(srb, cbw);
+	req[0].buffer = cbw;
+	req[0].length = UMASS_BBB_CBW_SIZE;
+	req[1].buffer = srb->pdata;
+	req[1].length = srb->datalen;
+	req[2].buffer = csw;
+	req[2].length = UMASS_BBB_CSW_SIZE;
+
+	if (dir_in) {
+		if (submit_bulk_queue(dev, pipein, &req[1], 2))
+			return BBB_QUEUE_NONE;
+		if (submit_bulk_queue(dev, pipeout, &req[0], 1)) {
+			cancel_bulk_queue(dev, pipein);
+			return BBB_QUEUE_NONE;
+		}
+	} else if (submit_bulk_queue(dev, pipeout, &req[0], 2)) {
+		return BBB_QUEUE_NONE;
+	}
+
+	if (wait_bulk_queue(dev, &req[0])) {
+		cancel_bulk_queue(dev, pipein);
+		return BBB_QUEUE_COMMAND;
+	}
+	/* On failure, this drops the CSW queued behind the data */
+	if (wait_bulk_queue(dev, &req[1]))
+		return BBB_QUEUE_DATA;
+	*data_actlen = dev->act_len;
+	if (!dir_in || wait_bulk_queue(dev, &req[2]))
+		return BBB_QUEUE_STATUS;
+
+	return BBB_QUEUE_DONE;
+}
+#endif
+
 static int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 {
 	int result, retry;
@@ -664,6 +768,37 @@ static int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 #endif
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
+	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+	data_actlen = 0;
+
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	if ((us->flags & USB_READY) && srb->datalen) {
+		switch (usb_stor_BBB_queue(srb, us, csw, &data_actlen)) {
+		case BBB_QUEUE_DONE:
+			return usb_stor_BBB_status(srb, us, csw, data_actlen);
+		case BBB_QUEUE_COMMAND:
+			debug("failed to send CBW status %ld\n",
+			      us->pusb_dev->status);
+			usb_stor_BBB_reset(us);
+			return USB_STOR_TRANSPORT_FAILED;
+		case BBB_QUEUE_DATA:
+			if ((us->pusb_dev->status & USB_ST_STALLED) &&
+			    usb_stor_BBB_clear_endpt_stall(us,
+				dir_in ? us->ep_in : us->ep_out) >= 0) {
+				debug("DATA:stall\n");
+				goto st;
+			}
+			debug("usb_bulk_msg error status %ld\n",
+			      us->pusb_dev->status);
+			usb_stor_BBB_reset(us);
+			return USB_STOR_TRANSPORT_FAILED;
+		case BBB_QUEUE_STATUS:
+			goto st;
+		}
+		/* could not be queued, go step by step */
+	}
+#endif
 
 	/* COMMAND phase */
 	debug("COMMAND phase\n");
@@ -676,10 +811,7 @@ static int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 	}
 	if (!(us->flags & USB_READY))
 		mdelay(5);
-	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
-	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
-	data_actlen = 0;
 	/* no data, go immediately to the STATUS phase */
 	if (srb->datalen == 0)
 		goto st;
@@ -741,36 +873,7 @@ again:
 		printf("ptr[%d] %#x ", index, ptr[index]);
 	printf("\n");
 #endif
-	/* misuse pipe to get the residue */
-	pipe = le32_to_cpu(csw->dCSWDataResidue);
-	if (pipe == 0 && srb->datalen != 0 && srb->datalen - data_actlen != 0)
-		pipe = srb->datalen - data_actlen;
-	if (CSWSIGNATURE != le32_to_cpu(csw->dCSWSignature)) {
-		debug("!CSWSIGNATURE\n");
-		usb_stor_BBB_reset(us);
-		return USB_STOR_TRANSPORT_FAILED;
-	} else if ((CBWTag - 1) != le32_to_cpu(csw->dCSWTag)) {
-		debug("!Tag\n");
-		usb_stor_BBB_reset(us);
-		return USB_STOR_TRANSPORT_FAILED;
-	} else if (csw->bCSWStatus > CSWSTATUS_PHASE) {
-		debug(">PHASE\n");
-		usb_stor_BBB_reset(us);
-		return USB_STOR_TRANSPORT_FAILED;
-	} else if (csw->bCSWStatus == CSWSTATUS_PHASE) {
-		debug("=PHASE\n");
-		usb_stor_BBB_reset(us);
-		return USB_STOR_TRANSPORT_FAILED;
-	} else if (data_actlen > srb->datalen) {
-		debug("transferred %dB instead of %ldB\n",
-		      data_actlen, srb->datalen);
-		return USB_STOR_TRANSPORT_FAILED;
-	} else if (csw->bCSWStatus == CSWSTATUS_FAILED) {
-		debug("FAILED\n");
-		return USB_STOR_TRANSPORT_FAILED;
-	}
-
-	return result;
+	return usb_stor_BBB_status(srb, us, csw, data_actlen);
 }
 
 static int usb_stor_CB_transport(ccb *srb, struct us_data *us)
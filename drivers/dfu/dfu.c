@@ -13,6 +13,7 @@
 #include <mmc.h>
 #include <fat.h>
 #include <dfu.h>
+#include <div64.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
 
@@ -20,6 +21,7 @@ static bool dfu_reset_request;
 static LIST_HEAD(dfu_list);
 static int dfu_alt_num;
 static int alt_num_cnt;
+static struct dfu_entity *dfu_draining;	/* has a buffer half to write */
 
 bool dfu_reset(void)
 {
@@ -99,39 +101,128 @@ unsigned char *dfu_get_buf(void)
 	return dfu_buf;
 }
 
-static int dfu_write_buffer_drain(struct dfu_entity *dfu)
+/* Write up to @max bytes (0: all) of the buffer half being drained */
+static void dfu_drain_step(struct dfu_entity *dfu, long max)
 {
-	long w_size;
+	long len = dfu->d_left, w_size;
+	ulong start;
 	int ret;
 
-	/* flush size? */
-	w_size = dfu->i_buf - dfu->i_buf_start;
-	if (w_size == 0)
-		return 0;
+	if (max && len > max)
+		len = max;
+	w_size = len;
 
 	/* update CRC32 */
-	dfu->crc = crc32(dfu->crc, dfu->i_buf_start, w_size);
+	dfu->crc = crc32(dfu->crc, dfu->d_buf, len);
 
-	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
-	if (ret)
+	start = get_timer(0);
+	ret = dfu->write_medium(dfu, dfu->offset, dfu->d_buf, &w_size);
+	dfu->t_medium += get_timer(start);
+	if (ret) {
 		debug("%s: Write error!\n", __func__);
-
-	/* point back */
-	dfu->i_buf = dfu->i_buf_start;
+		if (!dfu->d_err)
+			dfu->d_err = ret;
+	}
 
 	/* update offset */
 	dfu->offset += w_size;
 
-	puts("#");
+	dfu->d_buf += len;
+	dfu->d_left -= len;
+	if (dfu->d_left == 0) {
+		dfu_draining = NULL;
+		puts("#");
+	}
+}
+
+/* Finish writing the buffer half in flight, if any */
+static int dfu_write_finish(struct dfu_entity *dfu)
+{
+	ulong start = get_timer(0);
+	int ret;
+
+	while (dfu->d_left)
+		dfu_drain_step(dfu, 0);
+	dfu->t_wait += get_timer(start);
+
+	ret = dfu->d_err;
+	dfu->d_err = 0;
+
+	return ret;
+}
+
+/*
+ * Hand the data collected so far to the medium. With two buffer halves
+ * it is written from dfu_poll() while the next half fills; otherwise it
+ * is written here and now.
+ */
+static int dfu_write_buffer_drain(struct dfu_entity *dfu)
+{
+	long w_size, half;
+	int ret, tret;
+
+	/* The other half has to be out before this one goes */
+	ret = dfu_write_finish(dfu);
+
+	/* flush size? */
+	w_size = dfu->i_buf - dfu->i_buf_start;
+	if (w_size == 0)
+		return ret;
+
+	dfu->d_buf = dfu->i_buf_start;
+	dfu->d_left = w_size;
+
+	if (!dfu->pingpong) {
+		/* point back */
+		dfu->i_buf = dfu->i_buf_start;
+		tret = dfu_write_finish(dfu);
+		return ret ? ret : tret;
+	}
+
+	/* switch halves */
+	half = dfu->i_buf_end - dfu->i_buf_start;
+	if (dfu->i_buf_start == dfu_buf)
+		dfu->i_buf_start = dfu_buf + half;
+	else
+		dfu->i_buf_start = dfu_buf;
+	dfu->i_buf_end = dfu->i_buf_start + half;
+	dfu->i_buf = dfu->i_buf_start;
+	dfu_draining = dfu;
 
 	return ret;
 }
 
+void dfu_poll(void)
+{
+	struct dfu_entity *dfu = dfu_draining;
+
+	if (!dfu)
+		return;
+
+	/*
+	 * A medium that can take its writes in pieces gets one piece per
+	 * call, so the gadget is not kept waiting for a whole buffer half.
+	 */
+	dfu_drain_step(dfu, dfu->write_chunk);
+}
+
+static void dfu_show_stats(struct dfu_entity *dfu)
+{
+	ulong ms = max(get_timer(dfu->t_start), 1UL);
+
+	printf("\nDFU %s: %llu bytes in %lu ms, %lu KiB/s", dfu->name,
+	       dfu->offset, ms, (ulong)(lldiv(dfu->offset * 1000, ms) >> 10));
+	printf(" (medium %lu ms, waited for medium %lu ms)\n",
+	       dfu->t_medium, dfu->t_wait);
+}
+
 int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
-	int ret = 0;
+	int ret;
+
+	ret = dfu_write_finish(dfu);
 
-	if (dfu->flush_medium)
+	if (dfu->flush_medium && !ret)
 		ret = dfu->flush_medium(dfu);
 
 	printf("\nDFU complete CRC32: 0x%08x\n", dfu->crc);
@@ -144,6 +235,7 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	dfu->i_buf_start = dfu_buf;
 	dfu->i_buf_end = dfu_buf;
 	dfu->i_buf = dfu->i_buf_start;
+	dfu->d_left = 0;
 	dfu->inited = 0;
 
 	return ret;
@@ -151,6 +243,7 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
+	unsigned long half;
 	int ret = 0;
 	int tret;
 
@@ -167,8 +260,24 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 		dfu->i_buf_start = dfu_get_buf();
 		if (dfu->i_buf_start == NULL)
 			return -ENOMEM;
-		dfu->i_buf_end = dfu_get_buf() + dfu_buf_size;
+
+		/*
+		 * Use the buffer as two halves, one filling while the other
+		 * is written out, unless the caller receives straight into
+		 * it (thor). Halves stay 4 KiB aligned for DMA and blocks.
+		 */
+		half = (dfu_buf_size / 2) & ~0xfffUL;
+		dfu->pingpong = half && ((u8 *)buf < dfu_buf ||
+				(u8 *)buf >= dfu_buf + dfu_buf_size);
+		dfu->i_buf_end = dfu->i_buf_start +
+				 (dfu->pingpong ? half : dfu_buf_size);
 		dfu->i_buf = dfu->i_buf_start;
+		dfu->d_left = 0;
+		dfu->d_err = 0;
+
+		dfu->t_start = get_timer(0);
+		dfu->t_medium = 0;
+		dfu->t_wait = 0;
 
 		dfu->inited = 1;
 	}
@@ -219,6 +328,14 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 			ret = tret;
 	}
 
+	/* at the end, wait for everything to be on the medium */
+	if (size == 0) {
+		tret = dfu_write_finish(dfu);
+		if (ret == 0)
+			ret = tret;
+		dfu_show_stats(dfu);
+	}
+
 	return ret = 0 ? size : ret;
 }
 
@@ -373,6 +490,8 @@ void dfu_free_entities(void)
 {
 	struct dfu_entity *dfu, *p, *t = NULL;
 
+	dfu_draining = NULL;
+
 	list_for_each_entry_safe_reverse(dfu, p, &dfu_list, list) {
 		list_del(&dfu->list);
 		t = dfu;
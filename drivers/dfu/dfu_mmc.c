@@ -13,11 +13,88 @@
 #include <div64.h>
 #include <dfu.h>
 #include <mmc.h>
+#ifdef CONFIG_IMAGE_SPARSE
+#include <image-sparse.h>
+#endif
 
 static unsigned char __aligned(CONFIG_SYS_CACHELINE_SIZE)
 				dfu_file_buf[CONFIG_SYS_DFU_MAX_FILE_SIZE];
 static long dfu_file_buf_len;
 
+#ifdef CONFIG_IMAGE_SPARSE
+static struct sparse_storage dfu_sparse_info;
+static struct sparse_stream dfu_sparse;
+static int dfu_sparse_on;
+
+static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
+				 lbaint_t blkcnt, const void *buffer)
+{
+	struct dfu_entity *dfu = info->priv;
+	struct mmc *mmc = find_mmc_device(dfu->dev_num);
+
+	debug("%s: dev: %d start: " LBAF " cnt: " LBAF "\n", __func__,
+	      dfu->dev_num, blk, blkcnt);
+
+	return mmc->block_dev.block_write(dfu->dev_num, blk, blkcnt, buffer);
+}
+
+static int mmc_sparse_end(void)
+{
+	int ret;
+
+	if (!dfu_sparse_on)
+		return 0;
+	dfu_sparse_on = 0;
+
+	ret = sparse_stream_finish(&dfu_sparse);
+	printf("\nsparse: " LBAFU " blocks written, " LBAFU " skipped\n",
+	       dfu_sparse.written, dfu_sparse.skipped);
+
+	return ret;
+}
+
+/*
+ * Raw writes that start with a sparse image header are decoded on the
+ * fly instead of being written as they are.
+ */
+static int mmc_sparse_op(struct dfu_entity *dfu, u64 offset, void *buf,
+			 long *len)
+{
+	int ret;
+
+	if (offset == 0) {
+		mmc_sparse_end();
+		if (*len < (long)sizeof(u32) || !is_sparse_image(buf))
+			return 0;
+
+		dfu_sparse_info.blksz = dfu->data.mmc.lba_blk_size;
+		dfu_sparse_info.start = dfu->data.mmc.lba_start;
+		dfu_sparse_info.size = dfu->data.mmc.lba_size;
+		dfu_sparse_info.priv = dfu;
+		dfu_sparse_info.write = mmc_sparse_write;
+		sparse_stream_start(&dfu_sparse, &dfu_sparse_info);
+		dfu_sparse_on = 1;
+	}
+	if (!dfu_sparse_on)
+		return 0;
+
+	ret = sparse_stream_write(&dfu_sparse, buf, *len);
+
+	return ret ? ret : 1;
+}
+#else
+static inline int mmc_sparse_op(struct dfu_entity *dfu, u64 offset,
+				void *buf, long *len)
+{
+	return 0;
+}
+
+static inline int mmc_sparse_end(void)
+{
+	return 0;
+}
+#endif
+
 static int mmc_block_op(enum dfu_op op, struct dfu_entity *dfu,
 			u64 offset, void *buf, long *len)
 {
@@ -133,7 +210,12 @@ int dfu_write_medium_mmc(struct dfu_entity *dfu,
 
 	switch (dfu->layout) {
 	case DFU_RAW_ADDR:
-		ret = mmc_block_op(DFU_OP_WRITE, dfu, offset, buf, len);
+		/* 1: the data went to the sparse image decoder */
+		ret = mmc_sparse_op(dfu, offset, buf, len);
+		if (ret == 1)
+			ret = 0;
+		else if (ret == 0)
+			ret = mmc_block_op(DFU_OP_WRITE, dfu, offset, buf, len);
 		break;
 	case DFU_FS_FAT:
 	case DFU_FS_EXT4:
@@ -151,7 +233,9 @@ int dfu_flush_medium_mmc(struct dfu_entity *dfu)
 {
 	int ret = 0;
 
-	if (dfu->layout != DFU_RAW_ADDR) {
+	if (dfu->layout == DFU_RAW_ADDR) {
+		ret = mmc_sparse_end();
+	} else {
 		/* Do stuff here. */
 		ret = mmc_file_op(DFU_OP_WRITE, dfu, &dfu_file_buf,
 				&dfu_file_buf_len);
@@ -242,6 +326,7 @@ int dfu_fill_entity_mmc(struct dfu_entity *dfu, char *s)
 	dfu->read_medium = dfu_read_medium_mmc;
 	dfu->write_medium = dfu_write_medium_mmc;
 	dfu->flush_medium = dfu_flush_medium_mmc;
+	dfu->write_chunk = CONFIG_SYS_DFU_WRITE_CHUNK;
 
 	/* initial state */
 	dfu->inited = 0;
@@ -70,6 +70,7 @@ int dfu_fill_entity_ram(struct dfu_entity *dfu, char *s)
 
 	dfu->write_medium = dfu_write_medium_ram;
 	dfu->read_medium = dfu_read_medium_ram;
+	dfu->write_chunk = CONFIG_SYS_DFU_WRITE_CHUNK;
 
 	dfu->inited = 0;
 
@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bouncebuf.h>
 #include <malloc.h>
 #include <mmc.h>
 #include <asm/io.h>
@@ -24,11 +25,54 @@ struct sunxi_mmc_host {
 	unsigned mod_clk;
 	struct sunxi_mmc *reg;
 	struct mmc_config cfg;
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	struct sunxi_mmc_des *des;
+#endif
+#ifdef CONFIG_MMC_SUNXI_STATS
+	struct sunxi_mmc_cmd_stats stats[SUNXI_MMC_STATS_CMDS];
+#endif
 };
 
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+/* descriptors per host, bounds the size of a single transfer */
+#define SUNXI_MMC_DES_NUM	256
+#endif
+
 /* support 4 mmc hosts */
 struct sunxi_mmc_host mmc_host[4];
 
+/*
+ * Spin on a controller register until (value & mask) == want. There is no
+ * delay between reads so a completion is noticed within a few bus cycles;
+ * the deadline is only armed once the first read shows the event pending.
+ */
+static int mmc_poll(const char *what, u32 *reg, unsigned int mask,
+		    unsigned int want, unsigned int err_mask,
+		    unsigned long timeout_us)
+{
+	unsigned long start = 0;
+	unsigned int status;
+	int waited = 0;
+
+	for (;;) {
+		status = readl(reg);
+		if (status & err_mask) {
+			debug("%s error %x\n", what, status & err_mask);
+			return TIMEOUT;
+		}
+		if ((status & mask) == want)
+			return 0;
+
+		if (!waited) {
+			start = timer_get_us();
+			waited = 1;
+		} else if (timer_get_us() - start > timeout_us) {
+			debug("%s timeout %x\n", what, status);
+			return TIMEOUT;
+		}
+	}
+}
+
 static int mmc_resource_init(int sdc_no)
 {
 	struct sunxi_mmc_host *mmchost = &mmc_host[sdc_no];
@@ -67,10 +111,84 @@ static int mmc_resource_init(int sdc_no)
 	return 0;
 }
 
+/*
+ * Output / sample clock phase delays (in delay cell steps) per card clock
+ * range, as used by the Allwinner BSP. All generations supported here
+ * use the same values.
+ */
+static const struct {
+	unsigned int max_hz;
+	unsigned char oclk_dly;
+	unsigned char sclk_dly;
+} mmc_clk_delays[] = {
+	{   400000, 0, 0 },	/* identification */
+	{ 25000000, 0, 5 },	/* default speed */
+	{ 52000000, 3, 4 },	/* SD / MMC high speed */
+	{ ~0U,      1, 4 },
+};
+
+static void mmc_get_delays(unsigned int hz, int ddr, unsigned int *oclk_dly,
+			   unsigned int *sclk_dly)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(mmc_clk_delays) - 1; i++)
+		if (hz <= mmc_clk_delays[i].max_hz)
+			break;
+
+	*oclk_dly = mmc_clk_delays[i].oclk_dly;
+	*sclk_dly = mmc_clk_delays[i].sclk_dly;
+
+	/* DDR drives data on both edges, output one step earlier like Linux */
+	if (ddr && *oclk_dly)
+		(*oclk_dly)--;
+}
+
+/*
+ * Run the module clock at the card clock itself (the controller divider is
+ * left in bypass) so the phase delays above apply directly.
+ */
+static int mmc_set_mod_clk(struct sunxi_mmc_host *mmchost, unsigned int hz,
+			   int ddr)
+{
+	unsigned int pll, pll_hz, div, n, oclk_dly, sclk_dly;
+
+	if (hz <= 24000000) {
+		pll = CCM_MMC_CTRL_OSCM24;
+		pll_hz = 24000000;
+	} else {
+		pll = CCM_MMC_CTRL_PLL6;
+		pll_hz = clock_get_pll6();
+	}
+
+	div = DIV_ROUND_UP(pll_hz, hz);
+	n = 0;
+	while (div > 16) {
+		n++;
+		div = (div + 1) / 2;
+	}
+
+	if (n > 3) {
+		printf("mmc %u error cannot set clock to %u\n",
+		       mmchost->mmc_no, hz);
+		return -1;
+	}
+
+	mmc_get_delays(hz, ddr, &oclk_dly, &sclk_dly);
+
+	writel(CCM_MMC_CTRL_ENABLE | pll | CCM_MMC_CTRL_SCLK_DLY(sclk_dly) |
+	       CCM_MMC_CTRL_N(n) | CCM_MMC_CTRL_OCLK_DLY(oclk_dly) |
+	       CCM_MMC_CTRL_M(div), mmchost->mclkreg);
+	mmchost->mod_clk = pll_hz / (div << n);
+
+	debug("mmc %u set mod-clk req %u parent %u n %u m %u rate %u\n",
+	      mmchost->mmc_no, hz, pll_hz, 1u << n, div, mmchost->mod_clk);
+
+	return 0;
+}
+
 static int mmc_clk_io_on(int sdc_no)
 {
-	unsigned int pll_clk;
-	unsigned int divider;
 	struct sunxi_mmc_host *mmchost = &mmc_host[sdc_no];
 	struct sunxi_ccm_reg *ccm = (struct sunxi_ccm_reg *)SUNXI_CCM_BASE;
 
@@ -84,32 +202,22 @@ static int mmc_clk_io_on(int sdc_no)
 	setbits_le32(&ccm->ahb_reset0_cfg, 1 << AHB_RESET_OFFSET_MMC(sdc_no));
 #endif
 
-	/* config mod clock */
-	pll_clk = clock_get_pll6();
-	/* should be close to 100 MHz but no more, so round up */
-	divider = ((pll_clk + 99999999) / 100000000) - 1;
-	writel(CCM_MMC_CTRL_ENABLE | CCM_MMC_CTRL_PLL6 | divider,
-	       mmchost->mclkreg);
-	mmchost->mod_clk = pll_clk / (divider + 1);
-
-	return 0;
+	/* config mod clock, set_ios() picks the real card clock later */
+	return mmc_set_mod_clk(mmchost, 24000000, 0);
 }
 
 static int mmc_update_clk(struct mmc *mmc)
 {
 	struct sunxi_mmc_host *mmchost = mmc->priv;
 	unsigned int cmd;
-	unsigned timeout_msecs = 2000;
 
 	cmd = SUNXI_MMC_CMD_START |
 	      SUNXI_MMC_CMD_UPCLK_ONLY |
 	      SUNXI_MMC_CMD_WAIT_PRE_OVER;
 	writel(cmd, &mmchost->reg->cmd);
-	while (readl(&mmchost->reg->cmd) & SUNXI_MMC_CMD_START) {
-		if (!timeout_msecs--)
-			return -1;
-		udelay(1000);
-	}
+	if (mmc_poll("clk update", &mmchost->reg->cmd, SUNXI_MMC_CMD_START, 0,
+		     0, 2000000))
+		return -1;
 
 	/* clock update sets various irq status bits, clear these */
 	writel(readl(&mmchost->reg->rint), &mmchost->reg->rint);
@@ -117,10 +225,21 @@ static int mmc_update_clk(struct mmc *mmc)
 	return 0;
 }
 
-static int mmc_config_clock(struct mmc *mmc, unsigned div)
+static int mmc_config_clock(struct mmc *mmc)
 {
 	struct sunxi_mmc_host *mmchost = mmc->priv;
 	unsigned rval = readl(&mmchost->reg->clkcr);
+	unsigned int hz = mmc->clock;
+	unsigned div = 0;
+
+	/*
+	 * 8 bit DDR needs the module clock at twice the card clock with the
+	 * controller dividing it by two again.
+	 */
+	if (mmc->ddr_mode && mmc->bus_width == 8) {
+		hz <<= 1;
+		div = 1;
+	}
 
 	/* Disable Clock */
 	rval &= ~SUNXI_MMC_CLK_ENABLE;
@@ -128,6 +247,10 @@ static int mmc_config_clock(struct mmc *mmc, unsigned div)
 	if (mmc_update_clk(mmc))
 		return -1;
 
+	/* Set mod_clk to the new rate, including the phase delays */
+	if (mmc_set_mod_clk(mmchost, hz, mmc->ddr_mode))
+		return -1;
+
 	/* Change Divider Factor */
 	rval &= ~SUNXI_MMC_CLK_DIVIDER_MASK;
 	rval |= div;
@@ -147,15 +270,13 @@ static int mmc_config_clock(struct mmc *mmc, unsigned div)
 static void mmc_set_ios(struct mmc *mmc)
 {
 	struct sunxi_mmc_host *mmchost = mmc->priv;
-	unsigned int clkdiv = 0;
 
-	debug("set ios: bus_width: %x, clock: %d, mod_clk: %d\n",
-	      mmc->bus_width, mmc->clock, mmchost->mod_clk);
+	debug("set ios: bus_width: %x, clock: %d, ddr: %d\n",
+	      mmc->bus_width, mmc->clock, mmc->ddr_mode);
 
 	/* Change clock first */
-	clkdiv = (mmchost->mod_clk + (mmc->clock >> 1)) / mmc->clock / 2;
 	if (mmc->clock) {
-		if (mmc_config_clock(mmc, clkdiv)) {
+		if (mmc_config_clock(mmc)) {
 			mmchost->fatal_err = 1;
 			return;
 		}
@@ -168,6 +289,11 @@ static void mmc_set_ios(struct mmc *mmc)
 		writel(0x1, &mmchost->reg->width);
 	else
 		writel(0x0, &mmchost->reg->width);
+
+	if (mmc->ddr_mode)
+		setbits_le32(&mmchost->reg->gctrl, SUNXI_MMC_GCTRL_DDR_MODE);
+	else
+		clrbits_le32(&mmchost->reg->gctrl, SUNXI_MMC_GCTRL_DDR_MODE);
 }
 
 static int mmc_core_init(struct mmc *mmc)
@@ -176,7 +302,13 @@ static int mmc_core_init(struct mmc *mmc)
 
 	/* Reset controller */
 	writel(SUNXI_MMC_GCTRL_RESET, &mmchost->reg->gctrl);
-	udelay(1000);
+	if (mmc_poll("reset", &mmchost->reg->gctrl, SUNXI_MMC_GCTRL_RESET, 0,
+		     0, 1000))
+		return TIMEOUT;
+
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	writel(SUNXI_MMC_FTRGLEVEL_DMA, &mmchost->reg->ftrglevel);
+#endif
 
 	return 0;
 }
@@ -189,18 +321,15 @@ static int mmc_trans_data_by_cpu(struct mmc *mmc, struct mmc_data *data)
 					      SUNXI_MMC_STATUS_FIFO_FULL;
 	unsigned i;
 	unsigned byte_cnt = data->blocksize * data->blocks;
-	unsigned timeout_msecs = 2000;
 	unsigned *buff = (unsigned int *)(reading ? data->dest : data->src);
 
 	/* Always read / write data through the CPU */
 	setbits_le32(&mmchost->reg->gctrl, SUNXI_MMC_GCTRL_ACCESS_BY_AHB);
 
 	for (i = 0; i < (byte_cnt >> 2); i++) {
-		while (readl(&mmchost->reg->status) & status_bit) {
-			if (!timeout_msecs--)
-				return -1;
-			udelay(1000);
-		}
+		if (mmc_poll("fifo", &mmchost->reg->status, status_bit, 0, 0,
+			     2000000))
+			return -1;
 
 		if (reading)
 			buff[i] = readl(mmchost->database);
@@ -211,35 +340,165 @@ static int mmc_trans_data_by_cpu(struct mmc *mmc, struct mmc_data *data)
 	return 0;
 }
 
-static int mmc_rint_wait(struct mmc *mmc, unsigned int timeout_msecs,
-			 unsigned int done_bit, const char *what)
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+/*
+ * Single block transfers (and the short register reads done during card
+ * identification) are cheaper through the FIFO than setting up DMA.
+ */
+static int mmc_use_dma(struct mmc *mmc, struct mmc_data *data)
 {
 	struct sunxi_mmc_host *mmchost = mmc->priv;
-	unsigned int status;
 
+	return mmchost->des && data->blocks > 1 &&
+	       data->blocksize * data->blocks <=
+			SUNXI_MMC_DES_NUM * SUNXI_MMC_DES_MAX_LEN;
+}
+
+static int mmc_trans_data_by_dma(struct mmc *mmc, struct mmc_data *data,
+				 struct bounce_buffer *bbstate)
+{
+	struct sunxi_mmc_host *mmchost = mmc->priv;
+	struct sunxi_mmc_des *des = mmchost->des;
+	const int reading = !!(data->flags & MMC_DATA_READ);
+	unsigned byte_cnt = data->blocksize * data->blocks;
+	unsigned buff, len, i = 0;
+	unsigned rval;
+	int ret;
+
+	if (reading)
+		ret = bounce_buffer_start(bbstate, data->dest, byte_cnt,
+					  GEN_BB_WRITE);
+	else
+		ret = bounce_buffer_start(bbstate, (void *)data->src, byte_cnt,
+					  GEN_BB_READ);
+	if (ret)
+		return ret;
+
+	/* Build one chained descriptor per SUNXI_MMC_DES_MAX_LEN bytes */
+	buff = (unsigned)bbstate->bounce_buffer;
 	do {
-		status = readl(&mmchost->reg->rint);
-		if (!timeout_msecs-- ||
-		    (status & SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT)) {
-			debug("%s timeout %x\n", what,
-			      status & SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT);
-			return TIMEOUT;
-		}
-		udelay(1000);
-	} while (!(status & done_bit));
+		len = min(byte_cnt, (unsigned)SUNXI_MMC_DES_MAX_LEN);
+		des[i].config = SUNXI_MMC_DES_CHAIN | SUNXI_MMC_DES_OWN |
+				SUNXI_MMC_DES_DIC;
+		des[i].buf_size = len;
+		des[i].buf_addr = buff;
+		des[i].next_desc = (unsigned)&des[i + 1];
+		buff += len;
+		byte_cnt -= len;
+		i++;
+	} while (byte_cnt);
+
+	des[0].config |= SUNXI_MMC_DES_FIRST;
+	des[i - 1].config |= SUNXI_MMC_DES_LAST | SUNXI_MMC_DES_END_OF_RING;
+	des[i - 1].config &= ~SUNXI_MMC_DES_DIC;
+	des[i - 1].next_desc = 0;
+	flush_dcache_range((unsigned long)des,
+			   (unsigned long)des +
+			   roundup(i * sizeof(*des), ARCH_DMA_MINALIGN));
+
+	/* Hand the FIFO over to the internal DMA controller */
+	rval = readl(&mmchost->reg->gctrl);
+	rval &= ~SUNXI_MMC_GCTRL_ACCESS_BY_AHB;
+	rval |= SUNXI_MMC_GCTRL_DMA_ENABLE | SUNXI_MMC_GCTRL_DMA_RESET;
+	writel(rval, &mmchost->reg->gctrl);
+
+	writel(SUNXI_MMC_IDMAC_RESET, &mmchost->reg->dmac);
+	/* Completion is polled, keep the DMA interrupts masked */
+	writel(0, &mmchost->reg->idie);
+	writel(0xffffffff, &mmchost->reg->idst);
+	writel((unsigned)des, &mmchost->reg->dlba);
+	writel(SUNXI_MMC_IDMAC_FIXBURST | SUNXI_MMC_IDMAC_ENABLE,
+	       &mmchost->reg->dmac);
 
 	return 0;
 }
 
+/*
+ * Stop the internal DMA controller and end the bounce. With @done_bit set,
+ * first wait for the last descriptor to complete (RX for reads, TX for
+ * writes) or for an IDMAC error; without it the transfer is being aborted.
+ */
+static int mmc_dma_finish(struct mmc *mmc, struct bounce_buffer *bbstate,
+			  unsigned int done_bit)
+{
+	struct sunxi_mmc_host *mmchost = mmc->priv;
+	int error = 0;
+
+	if (done_bit)
+		error = mmc_poll("dma", &mmchost->reg->idst, done_bit,
+				 done_bit, SUNXI_MMC_IDST_ERROR_BIT, 100000);
+
+	writel(0, &mmchost->reg->dmac);
+	writel(0xffffffff, &mmchost->reg->idst);
+	clrbits_le32(&mmchost->reg->gctrl, SUNXI_MMC_GCTRL_DMA_ENABLE);
+	bounce_buffer_stop(bbstate);
+
+	return error;
+}
+#endif
+
+static int mmc_rint_wait(struct mmc *mmc, unsigned long timeout_us,
+			 unsigned int done_bit, const char *what)
+{
+	struct sunxi_mmc_host *mmchost = mmc->priv;
+
+	return mmc_poll(what, &mmchost->reg->rint, done_bit, done_bit,
+			SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT, timeout_us);
+}
+
+#ifdef CONFIG_MMC_SUNXI_STATS
+static void mmc_account_cmd(struct sunxi_mmc_host *mmchost,
+			    struct mmc_cmd *cmd, unsigned long start_us,
+			    int error)
+{
+	struct sunxi_mmc_cmd_stats *st;
+	unsigned long us = timer_get_us() - start_us;
+
+	if (cmd->cmdidx >= SUNXI_MMC_STATS_CMDS)
+		return;
+
+	st = &mmchost->stats[cmd->cmdidx];
+	st->count++;
+	if (error)
+		st->errors++;
+	st->total_us += us;
+	if (us > st->max_us)
+		st->max_us = us;
+}
+
+const struct sunxi_mmc_cmd_stats *sunxi_mmc_get_stats(int sdc_no)
+{
+	if (sdc_no < 0 || sdc_no >= ARRAY_SIZE(mmc_host) ||
+	    !mmc_host[sdc_no].reg)
+		return NULL;
+
+	return mmc_host[sdc_no].stats;
+}
+
+void sunxi_mmc_reset_stats(int sdc_no)
+{
+	if (sdc_no < 0 || sdc_no >= ARRAY_SIZE(mmc_host))
+		return;
+
+	memset(mmc_host[sdc_no].stats, 0, sizeof(mmc_host[sdc_no].stats));
+}
+#endif
+
 static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data)
 {
 	struct sunxi_mmc_host *mmchost = mmc->priv;
 	unsigned int cmdval = SUNXI_MMC_CMD_START;
-	unsigned int timeout_msecs;
+	unsigned long timeout_us;
 	int error = 0;
-	unsigned int status = 0;
 	unsigned int bytecnt = 0;
+	int use_dma = 0;
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	struct bounce_buffer bbstate;
+#endif
+#ifdef CONFIG_MMC_SUNXI_STATS
+	unsigned long start_us = timer_get_us();
+#endif
 
 	if (mmchost->fatal_err)
 		return -1;
@@ -258,7 +517,10 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		cmdval |= SUNXI_MMC_CMD_CHK_RESPONSE_CRC;
 
 	if (data) {
-		if ((u32) data->dest & 0x3) {
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+		use_dma = mmc_use_dma(mmc, data);
+#endif
+		if (!use_dma && ((u32) data->dest & 0x3)) {
 			error = -1;
 			goto out;
 		}
@@ -288,9 +550,23 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		int ret = 0;
 
 		bytecnt = data->blocksize * data->blocks;
-		debug("trans data %d bytes\n", bytecnt);
-		writel(cmdval | cmd->cmdidx, &mmchost->reg->cmd);
-		ret = mmc_trans_data_by_cpu(mmc, data);
+		debug("trans data %d bytes (%s)\n", bytecnt,
+		      use_dma ? "dma" : "cpu");
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+		if (use_dma) {
+			ret = mmc_trans_data_by_dma(mmc, data, &bbstate);
+			if (ret) {
+				use_dma = 0;
+				error = ret;
+				goto out;
+			}
+			writel(cmdval | cmd->cmdidx, &mmchost->reg->cmd);
+		} else
+#endif
+		{
+			writel(cmdval | cmd->cmdidx, &mmchost->reg->cmd);
+			ret = mmc_trans_data_by_cpu(mmc, data);
+		}
 		if (ret) {
 			error = readl(&mmchost->reg->rint) & \
 				SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT;
@@ -299,14 +575,17 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
-	error = mmc_rint_wait(mmc, 0xfffff, SUNXI_MMC_RINT_COMMAND_DONE, "cmd");
+	error = mmc_rint_wait(mmc, 2000000, SUNXI_MMC_RINT_COMMAND_DONE, "cmd");
 	if (error)
 		goto out;
 
 	if (data) {
-		timeout_msecs = 120;
-		debug("cacl timeout %x msec\n", timeout_msecs);
-		error = mmc_rint_wait(mmc, timeout_msecs,
+		timeout_us = 120000;
+		/* with DMA the whole transfer still lies ahead, allow 1 MB/s */
+		if (use_dma)
+			timeout_us += bytecnt;
+		debug("cacl timeout %lu usec\n", timeout_us);
+		error = mmc_rint_wait(mmc, timeout_us,
 				      data->blocks > 1 ?
 				      SUNXI_MMC_RINT_AUTO_COMMAND_DONE :
 				      SUNXI_MMC_RINT_DATA_OVER,
@@ -315,17 +594,23 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			goto out;
 	}
 
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	if (use_dma) {
+		use_dma = 0;
+		error = mmc_dma_finish(mmc, &bbstate,
+				       data->flags & MMC_DATA_READ ?
+				       SUNXI_MMC_IDST_RXIRQ :
+				       SUNXI_MMC_IDST_TXIRQ);
+		if (error)
+			goto out;
+	}
+#endif
+
 	if (cmd->resp_type & MMC_RSP_BUSY) {
-		timeout_msecs = 2000;
-		do {
-			status = readl(&mmchost->reg->status);
-			if (!timeout_msecs--) {
-				debug("busy timeout\n");
-				error = TIMEOUT;
-				goto out;
-			}
-			udelay(1000);
-		} while (status & SUNXI_MMC_STATUS_CARD_DATA_BUSY);
+		error = mmc_poll("busy", &mmchost->reg->status,
+				 SUNXI_MMC_STATUS_CARD_DATA_BUSY, 0, 0, 2000000);
+		if (error)
+			goto out;
 	}
 
 	if (cmd->resp_type & MMC_RSP_136) {
@@ -341,6 +626,10 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		debug("mmc resp 0x%08x\n", cmd->response[0]);
 	}
 out:
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	if (use_dma)
+		mmc_dma_finish(mmc, &bbstate, 0);
+#endif
 	if (error < 0) {
 		writel(SUNXI_MMC_GCTRL_RESET, &mmchost->reg->gctrl);
 		mmc_update_clk(mmc);
@@ -348,6 +637,9 @@ out:
 	writel(0xffffffff, &mmchost->reg->rint);
 	writel(readl(&mmchost->reg->gctrl) | SUNXI_MMC_GCTRL_FIFO_RESET,
 	       &mmchost->reg->gctrl);
+#ifdef CONFIG_MMC_SUNXI_STATS
+	mmc_account_cmd(mmchost, cmd, start_us, error);
+#endif
 
 	return error;
 }
@@ -369,8 +661,20 @@ int sunxi_mmc_init(int sdc_no)
 
 	cfg->voltages = MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->host_caps = MMC_MODE_4BIT;
+#ifdef CONFIG_MMC_SUNXI_8BIT_SLOT
+	if (sdc_no == CONFIG_MMC_SUNXI_8BIT_SLOT)
+		cfg->host_caps |= MMC_MODE_8BIT;
+#endif
 	cfg->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS;
+#ifdef CONFIG_MMC_SUNXI_DDR52
+	cfg->host_caps |= MMC_MODE_DDR_52MHz;
+#endif
 	cfg->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	/* keep multi-block transfers within one descriptor chain */
+	cfg->b_max = min(cfg->b_max, (uint)(SUNXI_MMC_DES_NUM *
+					   SUNXI_MMC_DES_MAX_LEN / 512));
+#endif
 
 	cfg->f_min = 400000;
 	cfg->f_max = 52000000;
@@ -378,6 +682,12 @@ int sunxi_mmc_init(int sdc_no)
 	mmc_resource_init(sdc_no);
 	mmc_clk_io_on(sdc_no);
 
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	/* without descriptors all transfers fall back to the FIFO */
+	mmc_host[sdc_no].des = memalign(ARCH_DMA_MINALIGN,
+				SUNXI_MMC_DES_NUM * sizeof(struct sunxi_mmc_des));
+#endif
+
 	if (mmc_create(cfg, &mmc_host[sdc_no]) == NULL)
 		return -1;
 
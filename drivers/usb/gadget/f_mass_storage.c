@@ -304,6 +304,13 @@ inline void clear_bit(int nr, volatile void *addr)
 struct fsg_dev;
 struct fsg_common;
 
+/* What the spare buffer holds */
+enum fsg_spare_state {
+	SPARE_EMPTY = 0,
+	SPARE_READ,		/* sectors after a run of sequential READs */
+	SPARE_WRITE,		/* the end of a WRITE, not yet on the medium */
+};
+
 /* Data shared by all the FSG instances. */
 struct fsg_common {
 	struct usb_gadget	*gadget;
@@ -317,6 +324,15 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
 
+	/* Read-ahead and write-behind, one buffer's worth */
+	void			*spare_buf;
+	enum fsg_spare_state	spare_state;
+	u32			spare_lba;
+	u32			spare_count;	/* in sectors */
+	int			spare_err;	/* a write-behind failed */
+	u32			ra_next;	/* sector after the last READ */
+	int			ra_seq;		/* it followed the one before */
+
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
 
@@ -632,6 +648,76 @@ static void start_transfer(struct fsg_dev *fsg, struct usb_ep *ep,
 #define START_TRANSFER(common, ep_name, req, pbusy, state)		\
 	START_TRANSFER_OR(common, ep_name, req, pbusy, state) (void)0
 
+/* Give @bh the spare buffer in exchange for its own */
+static void fsg_swap_spare(struct fsg_common *common, struct fsg_buffhd *bh)
+{
+	void *buf = bh->buf;
+
+	bh->buf = common->spare_buf;
+	bh->inreq->buf = bh->outreq->buf = bh->buf;
+	common->spare_buf = buf;
+}
+
+/*
+ * Put the end of the last WRITE on the medium, if it was held back.  A
+ * failure is reported with the next status that goes to the host.
+ */
+static int fsg_flush_spare(struct fsg_common *common)
+{
+	int rc;
+
+	if (common->spare_state != SPARE_WRITE)
+		return 0;
+	common->spare_state = SPARE_EMPTY;
+
+	rc = ums->write_sector(ums, common->spare_lba, common->spare_count,
+			       common->spare_buf);
+	if (rc != common->spare_count) {
+		printf("UMS: write-behind of %u sectors at %u failed\n",
+		       common->spare_count, common->spare_lba);
+		common->spare_err = 1;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Read ahead in pieces, so the last data and status go out meanwhile */
+#define FSG_RA_STEP	(FSG_BUFLEN / SECTOR_SIZE / 4)
+
+/*
+ * While the host prepares its next command after two sequential READs,
+ * read the sectors that follow into the spare buffer. Stop when the CBW
+ * in @bh arrives.
+ */
+static void fsg_read_ahead(struct fsg_common *common, struct fsg_buffhd *bh)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+	u32 count, done, n;
+
+	if (!common->ra_seq || common->spare_state != SPARE_EMPTY ||
+	    common->ra_next >= curlun->num_sectors)
+		return;
+	common->ra_seq = 0;
+
+	count = min(FSG_BUFLEN / SECTOR_SIZE,
+		    (u32)(curlun->num_sectors - common->ra_next));
+	for (done = 0; done < count && bh->state != BUF_STATE_FULL;
+	     done += n) {
+		n = min(count - done, (u32)FSG_RA_STEP);
+		if (ums->read_sector(ums, common->ra_next + done, n,
+				     common->spare_buf + done * SECTOR_SIZE)
+		    != n)
+			break;
+		usb_gadget_handle_interrupts();
+	}
+	if (!done)
+		return;
+	common->spare_lba = common->ra_next;
+	common->spare_count = done;
+	common->spare_state = SPARE_READ;
+}
+
 static void busy_indicator(void)
 {
 	static int state;
@@ -672,18 +758,24 @@ static int sleep_thread(struct fsg_common *common)
 
 		if (++i == 50000) {
 			busy_indicator();
+			/* Idle for a while, so write what was held back */
+			fsg_flush_spare(common);
 			i = 0;
 			k++;
 		}
 
 		if (k == 10) {
 			/* Handle CTRL+C */
-			if (ctrlc())
+			if (ctrlc()) {
+				fsg_flush_spare(common);
 				return -EPIPE;
+			}
 #ifdef CONFIG_USB_CABLE_CHECK
 			/* Check cable connection */
-			if (!usb_cable_connected())
+			if (!usb_cable_connected()) {
+				fsg_flush_spare(common);
 				return -EIO;
+			}
 #endif
 			k = 0;
 		}
@@ -705,8 +797,8 @@ static int do_read(struct fsg_common *common)
 	u32			amount_left;
 	loff_t			file_offset;
 	unsigned int		amount;
-	unsigned int		partial_page;
 	ssize_t			nread;
+	int			seq;
 
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
@@ -729,6 +821,10 @@ static int do_read(struct fsg_common *common)
 	}
 	file_offset = ((loff_t) lba) << 9;
 
+	/* Read ahead only for a run of sequential READs */
+	seq = lba == common->ra_next;
+	common->ra_seq = 0;
+
 	/* Carry out the file reads */
 	amount_left = common->data_size_from_cmnd;
 	if (unlikely(amount_left == 0))
@@ -740,15 +836,9 @@ static int do_read(struct fsg_common *common)
 		 * Try to read the remaining amount.
 		 * But don't read more than the buffer size.
 		 * And don't try to read past the end of the file.
-		 * Finally, if we're not at a page boundary, don't read past
-		 *	the next page.
 		 * If this means reading 0 then we were asked to read past
 		 *	the end of file. */
 		amount = min(amount_left, FSG_BUFLEN);
-		partial_page = file_offset & (PAGE_CACHE_SIZE - 1);
-		if (partial_page > 0)
-			amount = min(amount, (unsigned int) PAGE_CACHE_SIZE -
-					partial_page);
 
 		/* Wait for the next buffer to become available */
 		bh = common->next_buffhd_to_fill;
@@ -769,11 +859,21 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		/* Perform the read */
-		rc = ums->read_sector(ums,
-				      file_offset / SECTOR_SIZE,
-				      amount / SECTOR_SIZE,
-				      (char __user *)bh->buf);
+		/* Perform the read, unless it was done ahead of time */
+		if (common->spare_state == SPARE_READ &&
+		    common->spare_lba == file_offset / SECTOR_SIZE) {
+			amount = min(amount,
+				     common->spare_count * SECTOR_SIZE);
+			fsg_swap_spare(common, bh);
+			rc = amount / SECTOR_SIZE;
+		} else {
+			rc = ums->read_sector(ums,
+					      file_offset / SECTOR_SIZE,
+					      amount / SECTOR_SIZE,
+					      (char __user *)bh->buf);
+		}
+		if (common->spare_state == SPARE_READ)
+			common->spare_state = SPARE_EMPTY;
 		if (!rc)
 			return -EIO;
 
@@ -805,8 +905,12 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		if (amount_left == 0)
-			break;		/* No more left to read */
+		if (amount_left == 0) {
+			/* No more left to read */
+			common->ra_next = file_offset / SECTOR_SIZE;
+			common->ra_seq = seq;
+			break;
+		}
 
 		/* Send this buffer and go read some more */
 		bh->inreq->zero = 0;
@@ -832,9 +936,11 @@ static int do_write(struct fsg_common *common)
 	u32			amount_left_to_req, amount_left_to_write;
 	loff_t			usb_offset, file_offset;
 	unsigned int		amount;
-	unsigned int		partial_page;
 	ssize_t			nwritten;
 	int			rc;
+#ifdef CONFIG_USB_GADGET_STORAGE_WRITE_BEHIND
+	int			fua;
+#endif
 
 	if (curlun->ro) {
 		curlun->sense_data = SS_WRITE_PROTECTED;
@@ -861,6 +967,14 @@ static int do_write(struct fsg_common *common)
 		curlun->sense_data = SS_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
 		return -EINVAL;
 	}
+#ifdef CONFIG_USB_GADGET_STORAGE_WRITE_BEHIND
+	fua = common->cmnd[0] != SC_WRITE_6 && (common->cmnd[1] & 0x08);
+#endif
+
+	/* Whatever was read ahead may be about to change */
+	if (common->spare_state == SPARE_READ)
+		common->spare_state = SPARE_EMPTY;
+	common->ra_seq = 0;
 
 	/* Carry out the file writes */
 	get_some_more = 1;
@@ -878,16 +992,10 @@ static int do_write(struct fsg_common *common)
 			 * Try to get the remaining amount.
 			 * But don't get more than the buffer size.
 			 * And don't try to go past the end of the file.
-			 * If we're not at a page boundary,
-			 *	don't go past the next page.
 			 * If this means getting 0, then we were asked
 			 *	to write past the end of file.
 			 * Finally, round down to a block boundary. */
 			amount = min(amount_left_to_req, FSG_BUFLEN);
-			partial_page = usb_offset & (PAGE_CACHE_SIZE - 1);
-			if (partial_page > 0)
-				amount = min(amount,
-	(unsigned int) PAGE_CACHE_SIZE - partial_page);
 
 			if (amount == 0) {
 				get_some_more = 0;
@@ -943,6 +1051,31 @@ static int do_write(struct fsg_common *common)
 
 			amount = bh->outreq->actual;
 
+			/* What the last WRITE held back goes first */
+			if (fsg_flush_spare(common)) {
+				curlun->sense_data = SS_WRITE_ERROR;
+				curlun->info_valid = 1;
+				break;
+			}
+
+#ifdef CONFIG_USB_GADGET_STORAGE_WRITE_BEHIND
+			/* Hold the end of the data back in the spare buffer
+			 * and write it while the host reads the status and
+			 * sends the next command.  FUA wants it on the
+			 * medium first. */
+			if (!fua && amount == amount_left_to_write &&
+			    amount == bh->outreq->length) {
+				fsg_swap_spare(common, bh);
+				common->spare_lba = file_offset / SECTOR_SIZE;
+				common->spare_count = amount / SECTOR_SIZE;
+				common->spare_state = SPARE_WRITE;
+				file_offset += amount;
+				amount_left_to_write -= amount;
+				common->residue -= amount;
+				continue;
+			}
+#endif
+
 			/* Perform the write */
 			rc = ums->write_sector(ums,
 					       file_offset / SECTOR_SIZE,
@@ -987,7 +1120,12 @@ static int do_write(struct fsg_common *common)
 			continue;
 		}
 
-		/* Wait for something to happen */
+		/* Write what the last WRITE held back while the host's data
+		 * comes in, then wait for something to happen */
+		if (common->spare_state == SPARE_WRITE) {
+			fsg_flush_spare(common);
+			continue;
+		}
 		rc = sleep_thread(common);
 		if (rc)
 			return rc;
@@ -1000,6 +1138,7 @@ static int do_write(struct fsg_common *common)
 
 static int do_synchronize_cache(struct fsg_common *common)
 {
+	/* do_scsi_command() has written out anything held back */
 	return 0;
 }
 
@@ -1626,6 +1765,12 @@ static int send_status(struct fsg_common *common)
 			return rc;
 	}
 
+	/* A write-behind that failed fails the next command as well */
+	if (common->spare_err && curlun) {
+		common->spare_err = 0;
+		curlun->sense_data = SS_WRITE_ERROR;
+	}
+
 	if (curlun)
 		sd = curlun->sense_data;
 	else if (common->bad_lun_okay)
@@ -1805,6 +1950,11 @@ static int do_scsi_command(struct fsg_common *common)
 	common->phase_error = 0;
 	common->short_packet_received = 0;
 
+	/* Only another WRITE may go ahead of data held back */
+	if (common->cmnd[0] != SC_WRITE_6 && common->cmnd[0] != SC_WRITE_10 &&
+	    common->cmnd[0] != SC_WRITE_12)
+		fsg_flush_spare(common);
+
 	down_read(&common->filesem);	/* We're using the backing file */
 	switch (common->cmnd[0]) {
 
@@ -2143,6 +2293,9 @@ static int get_next_command(struct fsg_common *common)
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
 
+	/* Use the time until the CBW arrives */
+	fsg_read_ahead(common, bh);
+
 	/* Wait for the CBW to arrive */
 	while (bh->state != BUF_STATE_FULL) {
 		rc = sleep_thread(common);
@@ -2298,6 +2451,11 @@ static void handle_exception(struct fsg_common *common)
 	struct fsg_lun		*curlun;
 	unsigned int		exception_req_tag;
 
+	/* The host has been told held back data was written */
+	fsg_flush_spare(common);
+	common->spare_state = SPARE_EMPTY;
+	common->ra_seq = 0;
+
 	/* Cancel all the pending transfers */
 	if (common->fsg) {
 		for (i = 0; i < FSG_NUM_BUFFERS; ++i) {
@@ -2523,6 +2681,12 @@ buffhds_first_it:
 	} while (--i);
 	bh->next = common->buffhds;
 
+	common->spare_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
+	if (unlikely(!common->spare_buf)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
+
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
 		 "Linux   ",
@@ -2588,6 +2752,7 @@ static void fsg_common_release(struct kref *ref)
 			kfree(bh->buf);
 		} while (++bh, --i);
 	}
+	kfree(common->spare_buf);
 
 	if (common->free_storage_on_release)
 		kfree(common);
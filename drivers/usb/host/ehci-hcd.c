@@ -273,6 +273,58 @@ static inline u8 ehci_encode_speed(enum usb_device_speed speed)
 	return QH_FULL_SPEED;
 }
 
+/* Start or stop the async schedule, and wait for the controller to follow */
+static int ehci_set_async(struct ehci_ctrl *ctrl, int on)
+{
+	uint32_t cmd;
+	int ret;
+
+	cmd = ehci_readl(&ctrl->hcor->or_usbcmd);
+	if (on)
+		cmd |= CMD_ASE;
+	else
+		cmd &= ~CMD_ASE;
+	ehci_writel(&ctrl->hcor->or_usbcmd, cmd);
+
+	ret = handshake((uint32_t *)&ctrl->hcor->or_usbsts, STS_ASS,
+			on ? STS_ASS : 0, 100 * 1000);
+	if (ret < 0)
+		printf("EHCI fail timeout STS_ASS %s\n", on ? "set" : "reset");
+
+	return ret;
+}
+
+/* Turn the token of a completed qTD or QH overlay into a dev->status */
+static int ehci_td_status(uint32_t token)
+{
+	int status;
+
+	switch (QT_TOKEN_GET_STATUS(token) &
+		~(QT_TOKEN_STATUS_SPLITXSTATE | QT_TOKEN_STATUS_PERR)) {
+	case 0:
+		status = 0;
+		break;
+	case QT_TOKEN_STATUS_HALTED:
+		status = USB_ST_STALLED;
+		break;
+	case QT_TOKEN_STATUS_ACTIVE | QT_TOKEN_STATUS_DATBUFERR:
+	case QT_TOKEN_STATUS_DATBUFERR:
+		status = USB_ST_BUF_ERR;
+		break;
+	case QT_TOKEN_STATUS_HALTED | QT_TOKEN_STATUS_BABBLEDET:
+	case QT_TOKEN_STATUS_BABBLEDET:
+		status = USB_ST_BABBLE_DET;
+		break;
+	default:
+		status = USB_ST_CRC_ERR;
+		if (QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_HALTED)
+			status |= USB_ST_STALLED;
+		break;
+	}
+
+	return status;
+}
+
 static int
 ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *req)
@@ -286,7 +338,6 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	uint32_t *tdp;
 	uint32_t endpt, maxpacket, token, usbsts;
 	uint32_t c, toggle;
-	uint32_t cmd;
 	int timeout;
 	int ret = 0;
 	struct ehci_ctrl *ctrl = dev->controller;
@@ -380,7 +431,9 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	 *   qh_overlay.qt_next ...... 13-10 H
 	 * - qh_overlay.qt_altnext
 	 */
+#ifndef CONFIG_USB_EHCI_BULK_QUEUE
 	qh->qh_link = cpu_to_hc32((uint32_t)&ctrl->qh_list | QH_LINK_TYPE_QH);
+#endif
 	c = (dev->speed != USB_SPEED_HIGH) && !usb_pipeendpoint(pipe);
 	maxpacket = usb_maxpacket(dev, pipe);
 	endpt = QH_ENDPT1_RL(8) | QH_ENDPT1_C(c) |
@@ -515,6 +568,15 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		tdp = &qtd[qtd_counter++].qt_next;
 	}
 
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	/*
+	 * The list may only be changed while the controller is not walking
+	 * it; bulk queue heads can leave the async schedule running.
+	 */
+	if (ehci_set_async(ctrl, 0))
+		goto fail;
+	qh->qh_link = ctrl->qh_list.qh_link;
+#endif
 	ctrl->qh_list.qh_link = cpu_to_hc32((uint32_t)qh | QH_LINK_TYPE_QH);
 
 	/* Flush dcache */
@@ -531,16 +593,9 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	ehci_writel(&ctrl->hcor->or_usbsts, (usbsts & 0x3f));
 
 	/* Enable async. schedule. */
-	cmd = ehci_readl(&ctrl->hcor->or_usbcmd);
-	cmd |= CMD_ASE;
-	ehci_writel(&ctrl->hcor->or_usbcmd, cmd);
-
-	ret = handshake((uint32_t *)&ctrl->hcor->or_usbsts, STS_ASS, STS_ASS,
-			100 * 1000);
-	if (ret < 0) {
-		printf("EHCI fail timeout STS_ASS set\n");
+	ret = ehci_set_async(ctrl, 1);
+	if (ret < 0)
 		goto fail;
-	}
 
 	/* Wait for TDs to be processed. */
 	ts = get_timer(0);
@@ -578,44 +633,25 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		printf("EHCI timed out on TD - token=%#x\n", token);
 
 	/* Disable async schedule. */
-	cmd = ehci_readl(&ctrl->hcor->or_usbcmd);
-	cmd &= ~CMD_ASE;
-	ehci_writel(&ctrl->hcor->or_usbcmd, cmd);
-
-	ret = handshake((uint32_t *)&ctrl->hcor->or_usbsts, STS_ASS, 0,
-			100 * 1000);
-	if (ret < 0) {
-		printf("EHCI fail timeout STS_ASS reset\n");
+	ret = ehci_set_async(ctrl, 0);
+	if (ret < 0)
 		goto fail;
-	}
+
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	/* Leave the bulk queue heads behind it in the list */
+	ctrl->qh_list.qh_link = qh->qh_link;
+	flush_dcache_range((uint32_t)&ctrl->qh_list,
+		ALIGN_END_ADDR(struct QH, &ctrl->qh_list, 1));
+#endif
 
 	token = hc32_to_cpu(qh->qh_overlay.qt_token);
 	if (!(QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_ACTIVE)) {
 		debug("TOKEN=%#x\n", token);
-		switch (QT_TOKEN_GET_STATUS(token) &
-			~(QT_TOKEN_STATUS_SPLITXSTATE | QT_TOKEN_STATUS_PERR)) {
-		case 0:
+		dev->status = ehci_td_status(token);
+		if (!dev->status) {
 			toggle = QT_TOKEN_GET_DT(token);
 			usb_settoggle(dev, usb_pipeendpoint(pipe),
 				       usb_pipeout(pipe), toggle);
-			dev->status = 0;
-			break;
-		case QT_TOKEN_STATUS_HALTED:
-			dev->status = USB_ST_STALLED;
-			break;
-		case QT_TOKEN_STATUS_ACTIVE | QT_TOKEN_STATUS_DATBUFERR:
-		case QT_TOKEN_STATUS_DATBUFERR:
-			dev->status = USB_ST_BUF_ERR;
-			break;
-		case QT_TOKEN_STATUS_HALTED | QT_TOKEN_STATUS_BABBLEDET:
-		case QT_TOKEN_STATUS_BABBLEDET:
-			dev->status = USB_ST_BABBLE_DET;
-			break;
-		default:
-			dev->status = USB_ST_CRC_ERR;
-			if (QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_HALTED)
-				dev->status |= USB_ST_STALLED;
-			break;
 		}
 		dev->act_len = length - QT_TOKEN_GET_TOTALBYTES(token);
 	} else {
@@ -632,6 +668,15 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
 
 fail:
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	/* Do not leave the bulk queue heads behind our stack */
+	if (ctrl->qh_list.qh_link ==
+	    cpu_to_hc32((uint32_t)qh | QH_LINK_TYPE_QH)) {
+		ctrl->qh_list.qh_link = qh->qh_link;
+		flush_dcache_range((uint32_t)&ctrl->qh_list,
+			ALIGN_END_ADDR(struct QH, &ctrl->qh_list, 1));
+	}
+#endif
 	free(qtd);
 	return -1;
 }
@@ -970,6 +1015,16 @@ int usb_lowlevel_init(int index, enum usb_init_type init, void **controller)
 	/* Set async. queue head pointer. */
 	ehci_writel(&ehcic[index].hcor->or_asynclistaddr, (uint32_t)qh_list);
 
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	/* The bulk queue heads are kept, but are no longer in the list */
+	for (i = 0; i < EHCI_BULK_EPS; i++) {
+		ehcic[index].bulk[i].dev = NULL;
+		ehcic[index].bulk[i].linked = 0;
+		ehcic[index].bulk[i].head = 0;
+		ehcic[index].bulk[i].tail = 0;
+	}
+#endif
+
 	/*
 	 * Set up periodic list
 	 * Step 1: Parent QH for all periodic transfers.
@@ -1051,6 +1106,385 @@ done:
 	return 0;
 }
 
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+/*
+ * Bulk transfers do not go through ehci_submit_async(): each endpoint gets
+ * a queue head that stays in the async schedule, and the schedule is left
+ * running between transfers. Behind the queue head is a ring of qTDs whose
+ * last entry is kept inactive, so the controller stops there. A transfer
+ * is written from that entry onwards, followed by a new inactive one, and
+ * the first qTD is activated last; the controller picks it up on its next
+ * pass over the schedule. Several transfers can thus be queued at once.
+ *
+ * The data toggle is kept in the queue head. It is handed back to
+ * usb_settoggle() whenever the ring runs empty, and taken from
+ * usb_gettoggle() if that was changed meanwhile, e.g. by a clear halt.
+ */
+
+/* Bytes that fit into the qTD for @buf, as in ehci_submit_async() */
+static int ehci_td_bytes(uint8_t *buf, int left)
+{
+	int xfr_bytes = QT_BUFFER_CNT * EHCI_PAGE_SIZE;
+
+	xfr_bytes -= (uint32_t)buf & (EHCI_PAGE_SIZE - 1);
+	xfr_bytes &= ~(PKT_ALIGN - 1);
+
+	return min(xfr_bytes, left);
+}
+
+/* Number of qTDs a transfer needs */
+static int ehci_bulk_tds(uint8_t *buf, int length)
+{
+	int xfr_bytes, n = 0;
+
+	do {
+		xfr_bytes = ehci_td_bytes(buf, length);
+		buf += xfr_bytes;
+		length -= xfr_bytes;
+		n++;
+	} while (length > 0);
+
+	return n;
+}
+
+static int ehci_bulk_toggle(struct ehci_bulk_ep *ep)
+{
+	invalidate_dcache_range((uint32_t)ep->qh,
+		ALIGN_END_ADDR(struct QH, ep->qh, 1));
+
+	return QT_TOKEN_GET_DT(hc32_to_cpu(ep->qh->qh_overlay.qt_token));
+}
+
+/* Empty the ring; the controller must not be looking at the queue head */
+static void ehci_bulk_restart(struct ehci_bulk_ep *ep, int toggle)
+{
+	struct QH *qh = ep->qh;
+	struct qTD *td = &ep->tds[0];
+
+	memset(td, 0, sizeof(*td));
+	td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+	td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	flush_dcache_range((uint32_t)td, ALIGN_END_ADDR(struct qTD, td, 1));
+
+	qh->qh_curtd = 0;
+	memset(&qh->qh_overlay, 0, sizeof(qh->qh_overlay));
+	qh->qh_overlay.qt_next = cpu_to_hc32((uint32_t)td);
+	qh->qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	qh->qh_overlay.qt_token = cpu_to_hc32(QT_TOKEN_DT(toggle));
+	flush_dcache_range((uint32_t)qh, ALIGN_END_ADDR(struct QH, qh, 1));
+
+	ep->head = 0;
+	ep->tail = 0;
+	ep->seq++;
+}
+
+/* Drop whatever is queued, keeping the toggle where the controller left it */
+static void ehci_bulk_cancel(struct ehci_ctrl *ctrl, struct ehci_bulk_ep *ep)
+{
+	ehci_set_async(ctrl, 0);
+	ehci_bulk_restart(ep, ehci_bulk_toggle(ep));
+}
+
+static struct ehci_bulk_ep *ehci_bulk_find(struct usb_device *dev,
+					   unsigned long pipe)
+{
+	struct ehci_ctrl *ctrl = dev->controller;
+	int i;
+
+	for (i = 0; i < EHCI_BULK_EPS; i++)
+		if (ctrl->bulk[i].dev == dev && ctrl->bulk[i].pipe == pipe)
+			return &ctrl->bulk[i];
+
+	return NULL;
+}
+
+/* Find or set up the queue head for @pipe; NULL if none is free */
+static struct ehci_bulk_ep *ehci_bulk_ep(struct usb_device *dev,
+					 unsigned long pipe)
+{
+	static unsigned int uses;
+	struct ehci_ctrl *ctrl = dev->controller;
+	struct ehci_bulk_ep *ep = NULL;
+	uint32_t endpt1, endpt2;
+	void *mem;
+	int i, toggle;
+
+	endpt1 = QH_ENDPT1_RL(8) | QH_ENDPT1_C(0) |
+		QH_ENDPT1_MAXPKTLEN(usb_maxpacket(dev, pipe)) | QH_ENDPT1_H(0) |
+		QH_ENDPT1_DTC(QH_ENDPT1_DTC_IGNORE_QTD_TD) |
+		QH_ENDPT1_EPS(ehci_encode_speed(dev->speed)) |
+		QH_ENDPT1_ENDPT(usb_pipeendpoint(pipe)) | QH_ENDPT1_I(0) |
+		QH_ENDPT1_DEVADDR(usb_pipedevice(pipe));
+	endpt2 = QH_ENDPT2_MULT(1) | QH_ENDPT2_PORTNUM(dev->portnr) |
+		QH_ENDPT2_HUBADDR(dev->parent->devnum) |
+		QH_ENDPT2_UFCMASK(0) | QH_ENDPT2_UFSMASK(0);
+	toggle = usb_gettoggle(dev, usb_pipeendpoint(pipe), usb_pipeout(pipe));
+
+	ep = ehci_bulk_find(dev, pipe);
+	if (ep && ep->endpt1 == endpt1 && ep->endpt2 == endpt2) {
+		ep->used = ++uses;
+		if (ep->head != ep->tail || ehci_bulk_toggle(ep) == toggle)
+			return ep;
+		if (ehci_set_async(ctrl, 0))
+			return NULL;
+		ehci_bulk_restart(ep, toggle);
+		return ep;
+	}
+
+	/* Take an unused or the least recently used idle queue head */
+	if (!ep || ep->head != ep->tail) {
+		ep = NULL;
+		for (i = 0; i < EHCI_BULK_EPS; i++) {
+			if (ctrl->bulk[i].head != ctrl->bulk[i].tail)
+				continue;
+			if (!ep || !ctrl->bulk[i].dev ||
+			    (ep->dev && ctrl->bulk[i].used < ep->used))
+				ep = &ctrl->bulk[i];
+		}
+		if (!ep)
+			return NULL;
+	}
+
+	if (!ep->qh) {
+		mem = memalign(EHCI_PAGE_SIZE, EHCI_BULK_EP_SIZE);
+		if (!mem)
+			return NULL;
+		memset(mem, 0, EHCI_BULK_QH_SIZE);
+		ep->qh = mem;
+		ep->tds = mem + EHCI_BULK_QH_SIZE;
+	}
+
+	if (ehci_set_async(ctrl, 0))
+		return NULL;
+	ep->qh->qh_endpt1 = cpu_to_hc32(endpt1);
+	ep->qh->qh_endpt2 = cpu_to_hc32(endpt2);
+	if (!ep->linked)
+		ep->qh->qh_link = ctrl->qh_list.qh_link;
+	ehci_bulk_restart(ep, toggle);
+	if (!ep->linked) {
+		ctrl->qh_list.qh_link =
+			cpu_to_hc32((uint32_t)ep->qh | QH_LINK_TYPE_QH);
+		flush_dcache_range((uint32_t)&ctrl->qh_list,
+			ALIGN_END_ADDR(struct QH, &ctrl->qh_list, 1));
+		ep->linked = 1;
+	}
+	ep->dev = dev;
+	ep->pipe = pipe;
+	ep->endpt1 = endpt1;
+	ep->endpt2 = endpt2;
+	ep->used = ++uses;
+
+	return ep;
+}
+
+/* Write @nreq transfers into the ring, all or none */
+static int ehci_bulk_fill(struct ehci_bulk_ep *ep, struct bulk_req *req,
+			  int nreq)
+{
+	const int n = EHCI_BULK_TDS;
+	int in = usb_pipein(ep->pipe);
+	int i, idx, first, end, need, left, xfr_bytes;
+	struct qTD *td;
+	uint32_t token;
+	uint8_t *buf;
+
+	need = 0;
+	for (i = 0; i < nreq; i++) {
+		req[i].count = ehci_bulk_tds(req[i].buffer, req[i].length);
+		need += req[i].count;
+	}
+	if (need > n - 1 - (ep->tail - ep->head + n) % n)
+		return -ENOSPC;
+
+	first = ep->tail;
+	idx = first;
+	for (i = 0; i < nreq; i++) {
+		req[i].pipe = ep->pipe;
+		req[i].first = idx;
+		req[i].next = idx;
+		req[i].act_len = 0;
+		req[i].seq = ep->seq;
+
+		/* A short packet skips the rest of the transfer */
+		end = (idx + req[i].count) % n;
+		buf = req[i].buffer;
+		left = req[i].length;
+		do {
+			xfr_bytes = ehci_td_bytes(buf, left);
+			td = &ep->tds[idx];
+			ep->td_len[idx] = xfr_bytes;
+			idx = (idx + 1) % n;
+
+			td->qt_next = cpu_to_hc32((uint32_t)&ep->tds[idx]);
+			td->qt_altnext = cpu_to_hc32(in ?
+				(uint32_t)&ep->tds[end] : QT_NEXT_TERMINATE);
+			token = QT_TOKEN_TOTALBYTES(xfr_bytes) |
+				QT_TOKEN_IOC(0) | QT_TOKEN_CPAGE(0) |
+				QT_TOKEN_CERR(3) |
+				QT_TOKEN_PID(in ?
+					QT_TOKEN_PID_IN : QT_TOKEN_PID_OUT);
+			if (td != &ep->tds[first])
+				token |= QT_TOKEN_STATUS(QT_TOKEN_STATUS_ACTIVE);
+			td->qt_token = cpu_to_hc32(token);
+			ehci_td_buffer(td, buf, xfr_bytes);
+			flush_dcache_range((uint32_t)td,
+					   ALIGN_END_ADDR(struct qTD, td, 1));
+			buf += xfr_bytes;
+			left -= xfr_bytes;
+		} while (left > 0);
+	}
+
+	td = &ep->tds[idx];
+	memset(td, 0, sizeof(*td));
+	td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+	td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	flush_dcache_range((uint32_t)td, ALIGN_END_ADDR(struct qTD, td, 1));
+	ep->tail = idx;
+
+	td = &ep->tds[first];
+	td->qt_token |= cpu_to_hc32(QT_TOKEN_STATUS(QT_TOKEN_STATUS_ACTIVE));
+	flush_dcache_range((uint32_t)td, ALIGN_END_ADDR(struct qTD, td, 1));
+
+	return 0;
+}
+
+/* Returns 1 once @req is complete, with the token of its last qTD */
+static int ehci_bulk_done(struct ehci_bulk_ep *ep, struct bulk_req *req,
+			  uint32_t *tokenp)
+{
+	int end = (req->first + req->count) % EHCI_BULK_TDS;
+	struct qTD *td;
+	uint32_t token;
+
+	while (req->next != end) {
+		td = &ep->tds[req->next];
+		invalidate_dcache_range((uint32_t)td,
+					ALIGN_END_ADDR(struct qTD, td, 1));
+		token = hc32_to_cpu(td->qt_token);
+		*tokenp = token;
+		if (QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_ACTIVE)
+			return 0;
+
+		req->act_len += ep->td_len[req->next] -
+				QT_TOKEN_GET_TOTALBYTES(token);
+		req->next = (req->next + 1) % EHCI_BULK_TDS;
+		if ((QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_HALTED) ||
+		    QT_TOKEN_GET_TOTALBYTES(token))
+			break;
+	}
+
+	return 1;
+}
+
+int submit_bulk_queue(struct usb_device *dev, unsigned long pipe,
+		      struct bulk_req *req, int nreq)
+{
+	struct ehci_bulk_ep *ep;
+
+	if (usb_pipetype(pipe) != PIPE_BULK)
+		return -1;
+
+	ep = ehci_bulk_ep(dev, pipe);
+	if (!ep || ehci_bulk_fill(ep, req, nreq))
+		return -1;
+
+	return ehci_set_async(dev->controller, 1);
+}
+
+int wait_bulk_queue(struct usb_device *dev, struct bulk_req *req)
+{
+	struct ehci_bulk_ep *ep = ehci_bulk_find(dev, req->pipe);
+	uint32_t token = 0;
+	unsigned long ts;
+	int timeout;
+
+	dev->act_len = 0;
+	dev->status = USB_ST_NOT_PROC;
+	if (!ep || ep->seq != req->seq)
+		return -1;
+	/* A control transfer may have stopped the schedule meanwhile */
+	if (ehci_set_async(dev->controller, 1))
+		return -1;
+
+	ts = get_timer(0);
+	timeout = USB_TIMEOUT_MS(req->pipe);
+	while (!ehci_bulk_done(ep, req, &token)) {
+		if (get_timer(ts) >= timeout) {
+			printf("EHCI timed out on TD - token=%#x\n", token);
+			ehci_bulk_cancel(dev->controller, ep);
+			return -1;
+		}
+		WATCHDOG_RESET();
+	}
+
+	if (usb_pipein(req->pipe))
+		invalidate_dcache_range((uint32_t)req->buffer,
+			ALIGN((uint32_t)req->buffer + req->length,
+			      ARCH_DMA_MINALIGN));
+
+	dev->status = ehci_td_status(token);
+	dev->act_len = req->act_len;
+	ep->head = (req->first + req->count) % EHCI_BULK_TDS;
+	if (dev->status) {
+		debug("TOKEN=%#x\n", token);
+		ehci_bulk_cancel(dev->controller, ep);
+		return -1;
+	}
+	if (ep->head == ep->tail)
+		usb_settoggle(dev, usb_pipeendpoint(req->pipe),
+			      usb_pipeout(req->pipe), ehci_bulk_toggle(ep));
+
+	return 0;
+}
+
+void cancel_bulk_queue(struct usb_device *dev, unsigned long pipe)
+{
+	struct ehci_bulk_ep *ep = ehci_bulk_find(dev, pipe);
+
+	if (ep && ep->head != ep->tail)
+		ehci_bulk_cancel(dev->controller, ep);
+}
+
+/* A single transfer through the queue, in pieces the ring can take */
+static int ehci_bulk_msg(struct usb_device *dev, unsigned long pipe,
+			 void *buffer, int length)
+{
+	struct ehci_bulk_ep *ep = ehci_bulk_ep(dev, pipe);
+	struct bulk_req req;
+	int done = 0, tds;
+
+	/* Without a queue head of its own, take the slow path */
+	if (!ep || ep->head != ep->tail)
+		return ehci_submit_async(dev, pipe, buffer, length, NULL);
+
+	for (;;) {
+		req.buffer = buffer + done;
+		req.length = 0;
+		tds = 0;
+		do {
+			req.length += ehci_td_bytes(req.buffer + req.length,
+						    length - done - req.length);
+			tds++;
+		} while (done + req.length < length &&
+			 tds < EHCI_BULK_TDS - 1);
+
+		dev->act_len = 0;
+		if (submit_bulk_queue(dev, pipe, &req, 1) ||
+		    wait_bulk_queue(dev, &req)) {
+			dev->act_len += done;
+			break;
+		}
+		done += dev->act_len;
+		if (done >= length || dev->act_len < req.length) {
+			dev->act_len = done;
+			break;
+		}
+	}
+
+	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
+}
+#endif
+
 int
 submit_bulk_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 		int length)
@@ -1060,7 +1494,11 @@ submit_bulk_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 		debug("non-bulk pipe (type=%lu)", usb_pipetype(pipe));
 		return -1;
 	}
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	return ehci_bulk_msg(dev, pipe, buffer, length);
+#else
 	return ehci_submit_async(dev, pipe, buffer, length, NULL);
+#endif
 }
 
 int
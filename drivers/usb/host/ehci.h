@@ -238,6 +238,34 @@ struct QH {
 	};
 };
 
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+/*
+ * A bulk endpoint whose queue head stays in the async schedule, followed
+ * by a ring of qTDs in the same page-aligned block. The qTD at @tail is
+ * never active: the controller stops there, and the next transfer is
+ * built from it onwards.
+ */
+#define EHCI_BULK_EPS		4
+#define EHCI_BULK_EP_SIZE	(2 * EHCI_PAGE_SIZE)
+#define EHCI_BULK_QH_SIZE	128	/* QH, padded to keep qTDs in a page */
+#define EHCI_BULK_TDS	\
+	((EHCI_BULK_EP_SIZE - EHCI_BULK_QH_SIZE) / sizeof(struct qTD))
+
+struct ehci_bulk_ep {
+	struct QH *qh;
+	struct qTD *tds;
+	uint32_t td_len[EHCI_BULK_TDS];	/* bytes asked of each qTD */
+	struct usb_device *dev;		/* NULL if unused */
+	unsigned long pipe;
+	uint32_t endpt1, endpt2;
+	int linked;			/* in the async schedule */
+	int head;			/* oldest qTD not yet waited for */
+	int tail;			/* the inactive qTD */
+	int seq;			/* bumped when the ring is emptied */
+	unsigned int used;		/* for picking one to reuse */
+};
+#endif
+
 struct ehci_ctrl {
 	struct ehci_hccr *hccr;	/* R/O registers, not need for volatile */
 	struct ehci_hcor *hcor;
@@ -247,6 +275,9 @@ struct ehci_ctrl {
 	struct QH periodic_queue __aligned(USB_DMA_MINALIGN);
 	uint32_t *periodic_list;
 	int ntds;
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+	struct ehci_bulk_ep bulk[EHCI_BULK_EPS];
+#endif
 };
 
 /* Low level init functions */
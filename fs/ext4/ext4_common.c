@@ -1499,7 +1499,7 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
-long int read_allocated_block(struct ext2_inode *inode, int fileblock)
+long int read_allocated_block(struct ext2_inode *inode, lbaint_t fileblock)
 {
 	long int blknr;
 	int blksz;
@@ -1843,6 +1843,102 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	return blknr;
 }
 
+/*
+ * Resolve the extent of an extent mapped inode that covers @fileblock, or
+ * the hole around it, so that all of its blocks can be mapped without
+ * walking the extent tree again.
+ */
+static int ext4fs_lookup_extent(struct ext2_inode *inode, lbaint_t fileblock,
+				struct ext4_extent_cache *ec)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	uint32_t ee_block, ee_len;
+	int blksz, log2_blksz;
+	int i, entries, uninit;
+	char *buf;
+
+	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	buf = zalloc(blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	ext_block = ext4fs_get_extent_block(ext4fs_root, buf,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		free(buf);
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+	entries = le16_to_cpu(ext_block->eh_entries);
+	for (i = 0; i < entries; i++)
+		if (fileblock < le32_to_cpu(extent[i].ee_block))
+			break;
+
+	/* Assume a hole up to the next extent of this leaf */
+	ec->lblk = fileblock;
+	ec->len = i < entries ?
+		le32_to_cpu(extent[i].ee_block) - fileblock : 1;
+	ec->pblk = 0;
+
+	if (i > 0) {
+		ee_block = le32_to_cpu(extent[i - 1].ee_block);
+		ee_len = le16_to_cpu(extent[i - 1].ee_len);
+		uninit = ee_len > EXT_INIT_MAX_LEN;
+		if (uninit)
+			ee_len -= EXT_INIT_MAX_LEN;
+
+		if (fileblock - ee_block < ee_len) {
+			ec->lblk = ee_block;
+			ec->len = ee_len;
+			if (!uninit) {
+				ec->pblk = le16_to_cpu(extent[i - 1].ee_start_hi);
+				ec->pblk = (ec->pblk << 32) +
+					le32_to_cpu(extent[i - 1].ee_start_lo);
+			}
+		}
+	}
+
+	free(buf);
+
+	return 0;
+}
+
+/*
+ * read_allocated_block() for an open node. Extent mapped inodes keep the
+ * last resolved extent in the node, so sequential reads walk the extent
+ * tree once per extent rather than once per block.
+ */
+long int ext4fs_map_block(struct ext2fs_node *node, lbaint_t fileblock)
+{
+	struct ext4_extent_cache *ec = &node->extent_cache;
+	int err;
+
+	if (!(le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL))
+		return read_allocated_block(&node->inode, fileblock);
+
+	if (!ec->len || fileblock < ec->lblk ||
+	    fileblock - ec->lblk >= ec->len) {
+		err = ext4fs_lookup_extent(&node->inode, fileblock, ec);
+		if (err) {
+			ec->len = 0;
+			return err;
+		}
+	}
+
+	if (!ec->pblk)
+		return 0;
+
+	return ec->pblk + (fileblock - ec->lblk);
+}
+
 void ext4fs_close(void)
 {
 	if ((ext4fs_file != NULL) && (ext4fs_root != NULL)) {
@@ -1990,9 +2086,10 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 					printf("< ? > ");
 					break;
 				}
-				printf("%10d %s\n",
-					__le32_to_cpu(fdiro->inode.size),
-					filename);
+				printf("%10llu %s\n",
+				       (unsigned long long)
+				       ext4fs_inode_size(&fdiro->inode),
+				       filename);
 			}
 			free(fdiro);
 		}
@@ -2156,11 +2253,10 @@ int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 	return 1;
 }
 
-int ext4fs_open(const char *filename)
+int ext4fs_open(const char *filename, loff_t *len)
 {
 	struct ext2fs_node *fdiro = NULL;
 	int status;
-	int len;
 
 	if (ext4fs_root == NULL)
 		return -1;
@@ -2177,10 +2273,10 @@ int ext4fs_open(const char *filename)
 		if (status == 0)
 			goto fail;
 	}
-	len = __le32_to_cpu(fdiro->inode.size);
+	*len = ext4fs_inode_size(&fdiro->inode);
 	ext4fs_file = fdiro;
 
-	return len;
+	return 0;
 fail:
 	ext4fs_free_node(fdiro, &ext4fs_root->diropen);
 
@@ -2217,6 +2313,9 @@ int ext4fs_mount(unsigned part_length)
 	data->diropen.data = data;
 	data->diropen.ino = 2;
 	data->diropen.inode_read = 1;
+	/* the superblock read above spills into diropen */
+	memset(&data->diropen.extent_cache, 0,
+	       sizeof(data->diropen.extent_cache));
 	data->inode = &data->diropen.inode;
 
 	status = ext4fs_read_inode(data, 2, data->inode);
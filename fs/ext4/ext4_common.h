@@ -50,8 +50,20 @@ static inline void *zalloc(size_t size)
 
 int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
-int ext4fs_read_file(struct ext2fs_node *node, int pos,
+int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		unsigned int len, char *buf);
+
+/* Regular files keep the upper 32 bits of their size in dir_acl */
+static inline loff_t ext4fs_inode_size(struct ext2_inode *inode)
+{
+	loff_t size = __le32_to_cpu(inode->size);
+
+	if ((__le16_to_cpu(inode->mode) & FILETYPE_INO_MASK) ==
+	    FILETYPE_INO_REG)
+		size |= (loff_t)__le32_to_cpu(inode->dir_acl) << 32;
+
+	return size;
+}
 int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 			struct ext2fs_node **foundnode, int expecttype);
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
@@ -45,16 +45,18 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
  */
-int ext4fs_read_file(struct ext2fs_node *node, int pos,
+int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		unsigned int len, char *buf)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	lbaint_t i;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
-	unsigned int filesize = __le32_to_cpu(node->inode.size);
+	int log2_blocksize = log2_fs_blocksize + log2blksz;
+	loff_t filesize = ext4fs_inode_size(&node->inode);
+	lbaint_t firstblock = pos >> log2_blocksize;
 	lbaint_t previous_block_number = -1;
 	lbaint_t delayed_start = 0;
 	lbaint_t delayed_extent = 0;
@@ -64,17 +66,19 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 	short status;
 
 	/* Adjust len so it we can't read past the end of the file. */
-	if (len > filesize)
-		len = filesize;
+	if (pos >= filesize)
+		return 0;
+	if (len > filesize - pos)
+		len = filesize - pos;
 
-	blockcnt = ((len + pos) + blocksize - 1) / blocksize;
+	blockcnt = ((len + pos) + blocksize - 1) >> log2_blocksize;
 
-	for (i = pos / blocksize; i < blockcnt; i++) {
+	for (i = firstblock; i < blockcnt; i++) {
 		lbaint_t blknr;
-		int blockoff = pos % blocksize;
+		int blockoff = pos & (blocksize - 1);
 		int blockend = blocksize;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
+		blknr = ext4fs_map_block(node, i);
 		if (blknr < 0)
 			return -1;
 
@@ -82,7 +86,7 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 
 		/* Last block.  */
 		if (i == blockcnt - 1) {
-			blockend = (len + pos) % blocksize;
+			blockend = (len + pos) & (blocksize - 1);
 
 			/* The last portion is exactly blocksize. */
 			if (!blockend)
@@ -90,7 +94,7 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 		}
 
 		/* First block. */
-		if (i == pos / blocksize) {
+		if (i == firstblock) {
 			skipfirst = blockoff;
 			blockend -= skipfirst;
 		}
@@ -176,18 +180,17 @@ int ext4fs_ls(const char *dirname)
 
 int ext4fs_exists(const char *filename)
 {
-	int file_len;
+	loff_t file_len;
 
-	file_len = ext4fs_open(filename);
-	return file_len >= 0;
+	return ext4fs_open(filename, &file_len) == 0;
 }
 
-int ext4fs_read(char *buf, unsigned len)
+int ext4fs_read(char *buf, loff_t offset, unsigned len)
 {
 	if (ext4fs_root == NULL || ext4fs_file == NULL)
 		return 0;
 
-	return ext4fs_read_file(ext4fs_file, 0, len, buf);
+	return ext4fs_read_file(ext4fs_file, offset, len, buf);
 }
 
 int ext4fs_probe(block_dev_desc_t *fs_dev_desc,
@@ -203,26 +206,32 @@ int ext4fs_probe(block_dev_desc_t *fs_dev_desc,
 	return 0;
 }
 
-int ext4_read_file(const char *filename, void *buf, int offset, int len)
+int ext4_read_file(const char *filename, void *buf, loff_t offset, int len)
 {
-	int file_len;
+	loff_t file_len;
 	int len_read;
 
-	if (offset != 0) {
-		printf("** Cannot support non-zero offset **\n");
+	if (ext4fs_open(filename, &file_len) < 0) {
+		printf("** File not found %s **\n", filename);
 		return -1;
 	}
 
-	file_len = ext4fs_open(filename);
-	if (file_len < 0) {
-		printf("** File not found %s **\n", filename);
+	if (offset > file_len) {
+		printf("** Offset beyond end of file %s **\n", filename);
 		return -1;
 	}
 
-	if (len == 0)
-		len = file_len;
+	/* len == 0 reads up to the end, which has to fit a single call */
+	if (len == 0) {
+		if (file_len - offset > 0x7fffffff) {
+			printf("** File %s too large, give a length **\n",
+			       filename);
+			return -1;
+		}
+		len = file_len - offset;
+	}
 
-	len_read = ext4fs_read(buf, len);
+	len_read = ext4fs_read(buf, offset, len);
 
 	return len_read;
 }
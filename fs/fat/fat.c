@@ -52,6 +52,105 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 			cur_part_info.start + block, nr_blocks, buf);
 }
 
+#ifdef CONFIG_FAT_DENTRY_CACHE
+/*
+ * Directory entries found by path lookups, keyed by the first cluster of
+ * the directory searched and the (lowercase) name looked up. The cache
+ * lives as long as the same volume stays selected and is dropped on writes.
+ */
+struct fat_dcache_ent {
+	__u32		dirclust;
+	__u32		used;		/* LRU stamp, 0 if the slot is empty */
+	dir_entry	dent;
+	char		name[VFAT_MAXLEN_BYTES];
+};
+
+static struct fat_dcache_ent fat_dcache[CONFIG_FAT_DENTRY_CACHE];
+static __u32 fat_dcache_clock;
+static block_dev_desc_t *fat_dcache_dev;
+static lbaint_t fat_dcache_start;
+static __u8 fat_dcache_volid[4];
+
+static void fat_dcache_invalidate(void)
+{
+	memset(fat_dcache, 0, sizeof(fat_dcache));
+	fat_dcache_clock = 0;
+}
+
+/* Drop the cache unless the same partition is selected again */
+static void fat_dcache_select(block_dev_desc_t *dev_desc, lbaint_t start)
+{
+	if (dev_desc == fat_dcache_dev && start == fat_dcache_start)
+		return;
+
+	fat_dcache_invalidate();
+	fat_dcache_dev = dev_desc;
+	fat_dcache_start = start;
+}
+
+/* Drop the cache if another volume shows up, e.g. after a card swap */
+static void fat_dcache_check(volume_info *volinfo)
+{
+	if (!memcmp(fat_dcache_volid, volinfo->volume_id, 4))
+		return;
+
+	fat_dcache_invalidate();
+	memcpy(fat_dcache_volid, volinfo->volume_id, 4);
+}
+
+static int fat_dcache_lookup(__u32 dirclust, const char *name,
+			     dir_entry *dent)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_FAT_DENTRY_CACHE; i++) {
+		struct fat_dcache_ent *ent = &fat_dcache[i];
+
+		if (ent->used && ent->dirclust == dirclust &&
+		    !strcmp(ent->name, name)) {
+			ent->used = ++fat_dcache_clock;
+			memcpy(dent, &ent->dent, sizeof(dir_entry));
+			debug("dcache hit: %u/%s\n", dirclust, name);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void fat_dcache_insert(__u32 dirclust, const char *name,
+			      dir_entry *dent)
+{
+	struct fat_dcache_ent *ent = &fat_dcache[0];
+	int i;
+
+	if (strlen(name) >= VFAT_MAXLEN_BYTES)
+		return;
+
+	for (i = 1; i < CONFIG_FAT_DENTRY_CACHE; i++) {
+		if (fat_dcache[i].used < ent->used)
+			ent = &fat_dcache[i];
+	}
+
+	ent->dirclust = dirclust;
+	ent->used = ++fat_dcache_clock;
+	memcpy(&ent->dent, dent, sizeof(dir_entry));
+	strcpy(ent->name, name);
+}
+#else
+static inline void fat_dcache_invalidate(void) {}
+static inline void fat_dcache_select(block_dev_desc_t *dev_desc,
+				     lbaint_t start) {}
+static inline void fat_dcache_check(volume_info *volinfo) {}
+static inline int fat_dcache_lookup(__u32 dirclust, const char *name,
+				    dir_entry *dent)
+{
+	return 0;
+}
+static inline void fat_dcache_insert(__u32 dirclust, const char *name,
+				     dir_entry *dent) {}
+#endif
+
 int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
@@ -72,10 +171,11 @@ int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 	}
 
 	/* Check for FAT12/FAT16/FAT32 filesystem */
-	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3))
-		return 0;
-	if (!memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5))
+	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3) ||
+	    !memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5)) {
+		fat_dcache_select(dev_desc, info->start);
 		return 0;
+	}
 
 	cur_dev = NULL;
 	return -1;
@@ -154,6 +254,46 @@ static void get_name(dir_entry *dirent, char *s_name)
 	downcase(s_name);
 }
 
+/*
+ * Return the FAT window 'bufnum' from the cache, reading it into the least
+ * recently used slot if it is not present.
+ * On failure NULL is returned.
+ */
+static __u8 *get_fatwindow(fsdata *mydata, __u32 bufnum)
+{
+	__u32 getsize = FAT_CACHE_BLOCKS;
+	__u32 fatlength = mydata->fatlength;
+	__u32 startblock = bufnum * FAT_CACHE_BLOCKS;
+	__u8 *bufptr;
+	int i, lru = 0;
+
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		if (mydata->fatwin[i] == (int)bufnum) {
+			mydata->fatwinused[i] = ++mydata->fatwinclock;
+			return mydata->fatbuf + i * FATCACHESIZE;
+		}
+		if (mydata->fatwinused[i] < mydata->fatwinused[lru])
+			lru = i;
+	}
+
+	/* Read a new block of FAT entries into the cache. */
+	if (startblock + getsize > fatlength)
+		getsize = fatlength - startblock;
+
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	bufptr = mydata->fatbuf + lru * FATCACHESIZE;
+	mydata->fatwin[lru] = -1;
+	if (disk_read(startblock, getsize, bufptr) < 0) {
+		debug("Error reading FAT blocks\n");
+		return NULL;
+	}
+	mydata->fatwin[lru] = bufnum;
+	mydata->fatwinused[lru] = ++mydata->fatwinclock;
+
+	return bufptr;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
@@ -164,19 +304,20 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	__u32 off16, offset;
 	__u32 ret = 0x00;
 	__u16 val1, val2;
+	__u8 *fatbuf;
 
 	switch (mydata->fatsize) {
 	case 32:
-		bufnum = entry / FAT32BUFSIZE;
-		offset = entry - bufnum * FAT32BUFSIZE;
+		bufnum = entry / FAT32CACHESIZE;
+		offset = entry - bufnum * FAT32CACHESIZE;
 		break;
 	case 16:
-		bufnum = entry / FAT16BUFSIZE;
-		offset = entry - bufnum * FAT16BUFSIZE;
+		bufnum = entry / FAT16CACHESIZE;
+		offset = entry - bufnum * FAT16CACHESIZE;
 		break;
 	case 12:
-		bufnum = entry / FAT12BUFSIZE;
-		offset = entry - bufnum * FAT12BUFSIZE;
+		bufnum = entry / FAT12CACHESIZE;
+		offset = entry - bufnum * FAT12CACHESIZE;
 		break;
 
 	default:
@@ -187,57 +328,42 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%04x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	fatbuf = get_fatwindow(mydata, bufnum);
+	if (!fatbuf)
+		return ret;
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)fatbuf)[offset]);
 		break;
 	case 12:
 		off16 = (offset * 3) / 4;
 
 		switch (offset & 0x3) {
 		case 0:
-			ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[off16]);
+			ret = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			ret &= 0xfff;
 			break;
 		case 1:
-			val1 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			val1 = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			val1 &= 0xf000;
-			val2 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16 + 1]);
+			val2 = FAT2CPU16(((__u16 *)fatbuf)[off16 + 1]);
 			val2 &= 0x00ff;
 			ret = (val2 << 4) | (val1 >> 12);
 			break;
 		case 2:
-			val1 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			val1 = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			val1 &= 0xff00;
-			val2 = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16 + 1]);
+			val2 = FAT2CPU16(((__u16 *)fatbuf)[off16 + 1]);
 			val2 &= 0x000f;
 			ret = (val2 << 8) | (val1 >> 8);
 			break;
 		case 3:
-			ret = FAT2CPU16(((__u16 *)mydata->fatbuf)[off16]);
+			ret = FAT2CPU16(((__u16 *)fatbuf)[off16]);
 			ret = (ret & 0xfff0) >> 4;
 			break;
 		default:
@@ -314,6 +440,29 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Follow the cluster chain from 'clust' for at most 'maxclust' clusters while
+ * it stays physically contiguous. Return the number of clusters in the run
+ * and store the FAT entry that ends it in 'next' (undefined when the run
+ * reaches 'maxclust').
+ */
+static __u32 get_clustrun(fsdata *mydata, __u32 clust, __u32 maxclust,
+			  __u32 *next)
+{
+	__u32 run, newclust = 0;
+
+	for (run = 1; run < maxclust; run++) {
+		newclust = get_fatent(mydata, clust);
+		if (newclust != clust + 1 ||
+		    CHECK_CLUST(newclust, mydata->fatsize))
+			break;
+		clust = newclust;
+	}
+
+	*next = newclust;
+	return run;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
@@ -329,7 +478,7 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 	unsigned long filesize = FAT2CPU32(dentptr->size), gotsize = 0;
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	__u32 newclust, run;
 	unsigned long actsize;
 
 	debug("Filesize: %ld bytes\n", filesize);
@@ -386,50 +535,31 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return gotsize;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
-
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+	while (filesize) {
+		/* read the whole run of consecutive clusters at once */
+		run = get_clustrun(mydata, curclust,
+				   DIV_ROUND_UP(filesize, bytesperclust),
+				   &newclust);
+		actsize = min(filesize, (unsigned long)run * bytesperclust);
+		if (get_cluster(mydata, curclust, buffer, actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		gotsize += actsize;
-		return gotsize;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		gotsize += (int)actsize;
 		filesize -= actsize;
 		buffer += actsize;
+		if (!filesize)
+			break;
 
-		curclust = get_fatent(mydata, endclust);
+		curclust = newclust;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
 			return gotsize;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
+
+	return gotsize;
 }
 
 /*
@@ -580,10 +710,14 @@ static dir_entry *get_dentfromdir(fsdata *mydata, int startsect,
 {
 	__u16 prevcksum = 0xffff;
 	__u32 curclust = START(retdent);
+	__u32 dirclust = curclust;
 	int files = 0, dirs = 0;
 
 	debug("get_dentfromdir: %s\n", filename);
 
+	if (!dols && fat_dcache_lookup(dirclust, filename, retdent))
+		return retdent;
+
 	while (1) {
 		dir_entry *dentptr;
 
@@ -711,6 +845,7 @@ static dir_entry *get_dentfromdir(fsdata *mydata, int startsect,
 			}
 
 			memcpy(retdent, dentptr, sizeof(dir_entry));
+			fat_dcache_insert(dirclust, filename, retdent);
 
 			debug("DentName: %s", s_name);
 			debug(", start: 0x%x", START(dentptr));
@@ -816,6 +951,7 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	fsdata datablock;
 	fsdata *mydata = &datablock;
 	dir_entry *dentptr = NULL;
+	dir_entry rootdent;
 	__u16 prevcksum = 0xffff;
 	char *subname = "";
 	__u32 cursect;
@@ -823,7 +959,7 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	int files = 0, dirs = 0;
 	long ret = -1;
 	int firsttime;
-	__u32 root_cluster = 0;
+	__u32 root_cluster = 0, root_start;
 	int rootdir_size = 0;
 	int j;
 
@@ -831,6 +967,7 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 		debug("Error: reading boot sector\n");
 		return -1;
 	}
+	fat_dcache_check(&volinfo);
 
 	if (mydata->fatsize == 32) {
 		root_cluster = bs.root_cluster;
@@ -866,7 +1003,13 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	}
 
 	mydata->fatbufnum = -1;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
+	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN,
+				  FAT_CACHE_WINDOWS * FATCACHESIZE);
+	for (j = 0; j < FAT_CACHE_WINDOWS; j++) {
+		mydata->fatwin[j] = -1;
+		mydata->fatwinused[j] = 0;
+	}
+	mydata->fatwinclock = 0;
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
 		return -1;
@@ -910,6 +1053,15 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 		isdir = 1;
 	}
 
+	root_start = root_cluster;
+	if (dols != LS_ROOT &&
+	    fat_dcache_lookup(root_start, fnamecopy, &rootdent)) {
+		if (isdir && !(rootdent.attr & ATTR_DIR))
+			goto exit;
+		dentptr = &rootdent;
+		goto rootdir_done;
+	}
+
 	j = 0;
 	while (1) {
 		int i;
@@ -1052,6 +1204,8 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 				continue;
 			}
 
+			fat_dcache_insert(root_start, fnamecopy, dentptr);
+
 			if (isdir && !(dentptr->attr & ATTR_DIR))
 				goto exit;
 
@@ -1255,10 +1409,16 @@ long file_fat_read(const char *filename, void *buffer, unsigned long maxsize)
 	return file_fat_read_at(filename, 0, buffer, maxsize);
 }
 
-int fat_read_file(const char *filename, void *buf, int offset, int len)
+int fat_read_file(const char *filename, void *buf, loff_t offset, int len)
 {
 	int len_read;
 
+	/* FAT file sizes are 32 bit, nothing lies beyond */
+	if (offset >> 32) {
+		printf("** Offset beyond end of file %s **\n", filename);
+		return -1;
+	}
+
 	len_read = file_fat_read_at(filename, offset, buf, len);
 	if (len_read == -1) {
 		printf("** Unable to read file %s **\n", filename);
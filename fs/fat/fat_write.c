@@ -1074,6 +1074,7 @@ exit:
 
 int file_fat_write(const char *filename, void *buffer, unsigned long maxsize)
 {
+	fat_dcache_invalidate();
 	printf("writing %s\n", filename);
 	return do_fat_write(filename, buffer, maxsize);
 }
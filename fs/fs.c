@@ -19,6 +19,7 @@
 #include <part.h>
 #include <ext4fs.h>
 #include <fat.h>
+#include <hash.h>
 #include <fs.h>
 #include <sandboxfs.h>
 #include <asm/io.h>
@@ -47,7 +48,7 @@ static inline int fs_exists_unsupported(const char *filename)
 }
 
 static inline int fs_read_unsupported(const char *filename, void *buf,
-				      int offset, int len)
+				      loff_t offset, int len)
 {
 	return -1;
 }
@@ -77,7 +78,7 @@ struct fstype_info {
 		     disk_partition_t *fs_partition);
 	int (*ls)(const char *dirname);
 	int (*exists)(const char *filename);
-	int (*read)(const char *filename, void *buf, int offset, int len);
+	int (*read)(const char *filename, void *buf, loff_t offset, int len);
 	int (*write)(const char *filename, void *buf, int offset, int len);
 	void (*close)(void);
 };
@@ -223,7 +224,7 @@ int fs_exists(const char *filename)
 	return ret;
 }
 
-int fs_read(const char *filename, ulong addr, int offset, int len)
+int fs_read(const char *filename, ulong addr, loff_t offset, int len)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 	void *buf;
@@ -247,6 +248,60 @@ int fs_read(const char *filename, ulong addr, int offset, int len)
 	return ret;
 }
 
+/*
+ * Read a file in pieces for as long as image_stream_*() may be taking it,
+ * so that a kernel is uncompressed while the rest of it is still being
+ * read rather than after the whole file is in. Each piece also goes to
+ * hash_load_update() when "loadhash" is set, as tftp does with its
+ * blocks. Once neither wants the data, the rest is read in one go.
+ */
+#define FS_STREAM_CHUNK	(1 << 20)
+
+static int fs_read_stream(const char *filename, ulong addr, loff_t offset,
+			  int len)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	int done = 0, want, ret;
+	void *buf;
+
+	do {
+		want = FS_STREAM_CHUNK;
+		if (len && len - done < want)
+			want = len - done;
+		buf = map_sysmem(addr + done, want);
+		ret = info->read(filename, buf, offset + done, want);
+		if (ret > 0) {
+			image_stream_update(done, buf, ret);
+			hash_load_update(done, buf, ret);
+		}
+		unmap_sysmem(buf);
+		if (ret < 0)
+			goto out;
+		done += ret;
+	} while (ret == want && done != len &&
+		 (image_stream_busy() || hash_load_busy()));
+
+	if (ret == want && done != len) {
+		want = len ? len - done : 0;
+		buf = map_sysmem(addr + done, want);
+		ret = info->read(filename, buf, offset + done, want);
+		unmap_sysmem(buf);
+		if (ret < 0)
+			goto out;
+		done += ret;
+	}
+	ret = done;
+
+	if (len && ret != len) {
+		printf("** Unable to read file %s **\n", filename);
+		ret = -1;
+	}
+out:
+	fs_close();
+
+	return ret;
+}
+
 int fs_write(const char *filename, ulong addr, int offset, int len)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
@@ -273,7 +328,7 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	const char *addr_str;
 	const char *filename;
 	unsigned long bytes;
-	unsigned long pos;
+	loff_t pos;
 	int len_read;
 	unsigned long time;
 
@@ -308,12 +363,17 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	else
 		bytes = 0;
 	if (argc >= 7)
-		pos = simple_strtoul(argv[6], NULL, 16);
+		pos = simple_strtoull(argv[6], NULL, 16);
 	else
 		pos = 0;
 
+	hash_load_start();
+	image_stream_start(addr);
 	time = get_timer(0);
-	len_read = fs_read(filename, addr, pos, bytes);
+	if (image_stream_busy() || hash_load_busy())
+		len_read = fs_read_stream(filename, addr, pos, bytes);
+	else
+		len_read = fs_read(filename, addr, pos, bytes);
 	time = get_timer(time);
 	if (len_read <= 0)
 		return 1;
@@ -327,6 +387,8 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	puts("\n");
 
 	setenv_hex("filesize", len_read);
+	hash_load_finish(addr, len_read);
+	image_stream_finish(len_read);
 
 	return 0;
 }
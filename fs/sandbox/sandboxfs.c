@@ -13,7 +13,7 @@ int sandbox_fs_set_blk_dev(block_dev_desc_t *rbdd, disk_partition_t *info)
 	return 0;
 }
 
-long sandbox_fs_read_at(const char *filename, unsigned long pos,
+long sandbox_fs_read_at(const char *filename, loff_t pos,
 			     void *buffer, unsigned long maxsize)
 {
 	ssize_t size;
@@ -84,7 +84,7 @@ void sandbox_fs_close(void)
 {
 }
 
-int fs_read_sandbox(const char *filename, void *buf, int offset, int len)
+int fs_read_sandbox(const char *filename, void *buf, loff_t offset, int len)
 {
 	int len_read;
 
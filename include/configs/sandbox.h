@@ -84,6 +84,7 @@
 
 #define CONFIG_ENV_SIZE		8192
 #define CONFIG_ENV_IS_NOWHERE
+#define CONFIG_ENV_LAZY_IMPORT
 
 /* SPI */
 #define CONFIG_SANDBOX_SPI
@@ -130,6 +131,10 @@
 #define CONFIG_HASH_VERIFY
 #define CONFIG_SHA1
 #define CONFIG_SHA256
+#define CONFIG_CRC32_SLICE8
+#define CONFIG_IMAGE_STREAM
+#define CONFIG_IMAGE_SPARSE
+#define CONFIG_SMP_JOBS		/* jobs run on the calling CPU */
 
 #define CONFIG_TPM_TIS_SANDBOX
 
@@ -166,9 +171,11 @@
 #define CONFIG_BZIP2
 #define CONFIG_LZO
 #define CONFIG_LZMA
+#define CONFIG_LZ4
 
 #define CONFIG_TPM_TIS_SANDBOX
 
 #define CONFIG_CMD_LZMADEC
+#define CONFIG_CMD_UNLZ4
 
 #endif
@@ -22,6 +22,11 @@
 #define CONFIG_BOARD_POSTCLK_INIT 1
 #endif
 
+/* CONFIG_SMP_JOBS (opt-in, from boards.cfg) is for U-Boot proper only */
+#ifdef CONFIG_SPL_BUILD
+#undef CONFIG_SMP_JOBS
+#endif
+
 /*
  * Include common sunxi configuration where most the settings are
  */
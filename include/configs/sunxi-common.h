@@ -89,8 +89,15 @@
 #ifndef CONFIG_MMC_SUNXI_SLOT
 #define CONFIG_MMC_SUNXI_SLOT		0
 #endif
+/* boards with an 8 bit eMMC on sdc2 define CONFIG_MMC_SUNXI_8BIT_SLOT 2 */
+/* CONFIG_MMC_SUNXI_DDR52 enables eMMC DDR52, verify it on the board first */
 #define CONFIG_ENV_IS_IN_MMC
 #define CONFIG_SYS_MMC_ENV_DEV		0	/* first detected MMC controller */
+#ifndef CONFIG_SPL_BUILD
+#define CONFIG_MMC_SUNXI_USE_DMA	/* multi-block transfers via IDMAC */
+#define CONFIG_BOUNCE_BUFFER
+#define CONFIG_MMC_SUNXI_STATS		/* per command latency, "mmcstat" */
+#endif
 #endif
 
 /* 4MB of malloc() pool */
@@ -105,6 +112,21 @@
 #define CONFIG_SYS_MAXARGS	16	/* max number of command args */
 #define CONFIG_SYS_GENERIC_BOARD
 
+#ifndef CONFIG_SPL_BUILD
+#define CONFIG_CMD_HASH
+#define CONFIG_SHA1
+#define CONFIG_SHA256
+#define CONFIG_CMD_SHA1SUM
+#define CONFIG_SHA_NEON			/* NEON message schedule */
+#define CONFIG_HASH_LOAD		/* env loadhash: hash tftp/load data */
+#define CONFIG_IMAGE_STREAM		/* env loadunzip: gunzip while loading */
+#define CONFIG_CRC32_SLICE8		/* 8 KiB of tables, ~2x faster */
+#define CONFIG_LZ4
+#define CONFIG_CMD_UNLZ4
+#define CONFIG_IMAGE_SPARSE		/* Android sparse images to eMMC */
+#define CONFIG_CMD_MMC_SWRITE
+#endif
+
 /* Boot Argument Buffer Size */
 #define CONFIG_SYS_BARGSIZE		CONFIG_SYS_CBSIZE
 
@@ -130,6 +152,9 @@
 
 #define CONFIG_ENV_OFFSET		(544 << 10) /* (8 + 24 + 512) KiB */
 #define CONFIG_ENV_SIZE			(128 << 10)	/* 128 KiB */
+#define CONFIG_ENV_LAZY_IMPORT
+#define CONFIG_ENV_SAVE_DEFER
+#define CONFIG_ENV_MMC_INCREMENTAL
 
 #ifdef CONFIG_SPL_FEL
 #define RUN_BOOT_RAM	"run boot_ram;"
@@ -247,6 +272,9 @@
 #include <config_cmd_default.h>
 
 #define CONFIG_FAT_WRITE	/* enable write access */
+#define CONFIG_FAT_CACHE_BLOCKS		24	/* FAT sectors per window */
+#define CONFIG_FAT_CACHE_WINDOWS	8	/* FAT windows kept, LRU */
+#define CONFIG_FAT_DENTRY_CACHE		32	/* path lookups remembered */
 
 #define CONFIG_SPL_FRAMEWORK
 #define CONFIG_SPL_LIBCOMMON_SUPPORT
@@ -392,6 +420,7 @@
 /* Ethernet support */
 #ifdef CONFIG_SUNXI_EMAC
 #define CONFIG_MII			/* MII PHY management		*/
+#define CONFIG_SYS_RX_ETH_BUFFER	8	/* frames drained per recv */
 #endif
 
 #ifdef CONFIG_SUNXI_GMAC
@@ -409,6 +438,8 @@
 #define CONFIG_NETCONSOLE
 #define CONFIG_BOOTP_DNS2
 #define CONFIG_BOOTP_SEND_HOSTNAME
+#define CONFIG_TFTP_WINDOWSIZE		8	/* env tftpwindowsize */
+#define CONFIG_NFS_WINDOWSIZE		8	/* env nfswindowsize */
 #endif
 
 #if !defined CONFIG_ENV_IS_IN_MMC && \
@@ -77,6 +77,9 @@ static inline unsigned int get_mmc_blk_size(int dev)
 #ifndef CONFIG_SYS_DFU_MAX_FILE_SIZE
 #define CONFIG_SYS_DFU_MAX_FILE_SIZE CONFIG_SYS_DFU_DATA_BUF_SIZE
 #endif
+#ifndef CONFIG_SYS_DFU_WRITE_CHUNK
+#define CONFIG_SYS_DFU_WRITE_CHUNK	(64 << 10)	/* 64 KiB */
+#endif
 #ifndef DFU_DEFAULT_POLL_TIMEOUT
 #define DFU_DEFAULT_POLL_TIMEOUT 0
 #endif
@@ -106,6 +109,9 @@ struct dfu_entity {
 
 	int (*flush_medium)(struct dfu_entity *dfu);
 
+	/* write_medium may be called in pieces of this size, 0: not at all */
+	long write_chunk;
+
 	struct list_head list;
 
 	/* on the fly state */
@@ -118,9 +124,20 @@ struct dfu_entity {
 	long r_left;
 	long b_left;
 
+	/* half of the buffer being written out while the other one fills */
+	u8 *d_buf;
+	long d_left;
+	int d_err;
+
+	/* transfer statistics */
+	ulong t_start;
+	ulong t_medium;		/* ms spent in write_medium */
+	ulong t_wait;		/* ms the USB side waited for the medium */
+
 	u32 bad_skip;	/* for nand use */
 
 	unsigned int inited:1;
+	unsigned int pingpong:1;
 };
 
 int dfu_config_entities(char *s, char *interface, int num);
@@ -142,6 +159,7 @@ unsigned long dfu_get_buf_size(void);
 int dfu_read(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_flush(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
+void dfu_poll(void);
 /* Device specific */
 #ifdef CONFIG_DFU_MMC
 extern int dfu_fill_entity_mmc(struct dfu_entity *dfu, char *s);
@@ -146,6 +146,11 @@ extern unsigned long nand_env_oob_offset;
 extern char *env_name_spec;
 #endif
 
+#if defined(CONFIG_ENV_SAVE_DEFER) && defined(CONFIG_CMD_SAVEENV) && \
+	!defined(CONFIG_ENV_IS_NOWHERE) && !defined(CONFIG_SPL_BUILD)
+# define ENV_SAVE_DEFER
+#endif
+
 #define ENV_SIZE (CONFIG_ENV_SIZE - ENV_HEADER_SIZE)
 
 typedef struct environment_s {
@@ -201,6 +206,22 @@ int set_default_vars(int nvars, char * const vars[]);
 /* Import from binary representation into hash table */
 int env_import(const char *buf, int check);
 
+/*
+ * A saveenv run from a script is only noted and written out once the
+ * outermost command or script is done, so several saves cost one write.
+ * Anything that does not come back (booting an OS, reset) flushes first.
+ * env_save_release() returns non-zero if the write it triggered failed.
+ */
+#ifdef ENV_SAVE_DEFER
+void env_save_hold(void);
+int env_save_release(void);
+int env_save_flush(void);
+#else
+static inline void env_save_hold(void) {}
+static inline int env_save_release(void) { return 0; }
+static inline int env_save_flush(void) { return 0; }
+#endif
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENVIRONMENT_H_ */
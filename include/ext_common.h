@@ -154,11 +154,19 @@ struct ext2_dirent {
 	uint8_t filetype;
 };
 
+/* Last extent (or hole) resolved for an extent mapped inode */
+struct ext4_extent_cache {
+	uint32_t lblk;		/* first file block covered */
+	uint32_t len;		/* blocks covered, 0 if nothing cached */
+	uint64_t pblk;		/* first disk block, 0 for a hole */
+};
+
 struct ext2fs_node {
 	struct ext2_data *data;
 	struct ext2_inode inode;
 	int ino;
 	int inode_read;
+	struct ext4_extent_cache extent_cache;
 };
 
 /* Information about a "mounted" ext2 filesystem. */
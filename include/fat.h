@@ -23,11 +23,31 @@
 #define DIRENTSPERCLUST	((mydata->clust_size * mydata->sect_size) / \
 			 sizeof(dir_entry))
 
+/*
+ * fat_write.c works on a single window of FATBUFBLOCKS sectors of the FAT.
+ * The read path keeps FAT_CACHE_WINDOWS windows of FAT_CACHE_BLOCKS sectors
+ * and replaces the least recently used one on a miss. Both sizes must stay
+ * a multiple of 3 so FAT12 entries never straddle two windows.
+ */
 #define FATBUFBLOCKS	6
+#ifdef CONFIG_FAT_CACHE_BLOCKS
+#define FAT_CACHE_BLOCKS	CONFIG_FAT_CACHE_BLOCKS
+#else
+#define FAT_CACHE_BLOCKS	FATBUFBLOCKS
+#endif
+#ifdef CONFIG_FAT_CACHE_WINDOWS
+#define FAT_CACHE_WINDOWS	CONFIG_FAT_CACHE_WINDOWS
+#else
+#define FAT_CACHE_WINDOWS	1
+#endif
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
+#define FATCACHESIZE	(mydata->sect_size * FAT_CACHE_BLOCKS)
+#define FAT12CACHESIZE	((FATCACHESIZE*2)/3)
+#define FAT16CACHESIZE	(FATCACHESIZE/2)
+#define FAT32CACHESIZE	(FATCACHESIZE/4)
 
 
 /* Filesystem identifiers */
@@ -156,7 +176,7 @@ typedef struct dir_slot {
  * (see FAT32 accesses)
  */
 typedef struct {
-	__u8	*fatbuf;	/* Current FAT buffer */
+	__u8	*fatbuf;	/* Current FAT buffer, FAT_CACHE_WINDOWS when reading */
 	int	fatsize;	/* Size of FAT in bits */
 	__u32	fatlength;	/* Length of FAT in sectors */
 	__u16	fat_sect;	/* Starting sector of the FAT */
@@ -165,6 +185,9 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	int	fatwin[FAT_CACHE_WINDOWS];	/* FAT window held by each slot */
+	__u32	fatwinused[FAT_CACHE_WINDOWS];	/* LRU stamp of each slot */
+	__u32	fatwinclock;
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
@@ -197,6 +220,6 @@ int fat_set_blk_dev(block_dev_desc_t *rbdd, disk_partition_t *info);
 int fat_register_device(block_dev_desc_t *dev_desc, int part_no);
 
 int file_fat_write(const char *filename, void *buffer, unsigned long maxsize);
-int fat_read_file(const char *filename, void *buf, int offset, int len);
+int fat_read_file(const char *filename, void *buf, loff_t offset, int len);
 void fat_close(void);
 #endif /* _FAT_H_ */
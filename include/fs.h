@@ -53,13 +53,14 @@ int fs_exists(const char *filename);
 /*
  * Read file "filename" from the partition previously set by fs_set_blk_dev(),
  * to address "addr", starting at byte offset "offset", and reading "len"
- * bytes. "offset" may be 0 to read from the start of the file. "len" may be
- * 0 to read the entire file. Note that not all filesystem types support
- * either/both offset!=0 or len!=0.
+ * bytes. "offset" may be 0 to read from the start of the file, it is 64 bit
+ * so that ranges of files beyond 4GiB can be read. "len" may be 0 to read
+ * the entire file. Note that not all filesystem types support either/both
+ * offset!=0 or len!=0.
  *
  * Returns number of bytes read on success. Returns <= 0 on error.
  */
-int fs_read(const char *filename, ulong addr, int offset, int len);
+int fs_read(const char *filename, ulong addr, loff_t offset, int len);
 
 /*
  * Write file "filename" to the partition previously set by fs_set_blk_dev(),
@@ -27,6 +27,41 @@ struct hash_algo {
 	void (*hash_func_ws)(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 	int chunk_size;				/* Watchdog chunk size */
+	/*
+	 * hash_init: Create the context for progressive hashing
+	 *
+	 * The three functions below are NULL if the algorithm can only hash
+	 * a whole buffer at once.
+	 *
+	 * @algo:	Pointer to the hash_algo struct
+	 * @ctxp:	Pointer to the pointer of the context for hashing
+	 * @return 0 if ok, -ve on error
+	 */
+	int (*hash_init)(struct hash_algo *algo, void **ctxp);
+	/*
+	 * hash_update: Perform hashing on the given buffer
+	 *
+	 * @algo:	Pointer to the hash_algo struct
+	 * @ctx:	Pointer to the context for hashing
+	 * @buf:	Pointer to the buffer being hashed
+	 * @size:	Size of the buffer being hashed
+	 * @is_last:	1 if this is the last update; 0 otherwise
+	 * @return 0 if ok, -ve on error
+	 */
+	int (*hash_update)(struct hash_algo *algo, void *ctx, const void *buf,
+			   unsigned int size, int is_last);
+	/*
+	 * hash_finish: Write the hash result to the given buffer and free
+	 * the context
+	 *
+	 * @algo:	Pointer to the hash_algo struct
+	 * @ctx:	Pointer to the context for hashing
+	 * @dest_buf:	Pointer to the buffer for the result
+	 * @size:	Size of the buffer for the result
+	 * @return 0 if ok, -ENOSPC if size of the result buffer is too small
+	 */
+	int (*hash_finish)(struct hash_algo *algo, void *ctx, void *dest_buf,
+			   int size);
 };
 
 /*
@@ -77,4 +112,93 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+/* Default buffer size for hash_bench() */
+#define HASH_BENCH_SIZE		(1 << 20)
+
+/**
+ * hash_bench() - Measure the throughput of each hash algorithm
+ *
+ * Each algorithm hashes a buffer of @len bytes repeatedly for a while and
+ * the resulting throughput is printed.
+ *
+ * @len:		Size of the buffer to hash
+ * @return 0 if ok, -ENOMEM if the buffer cannot be allocated
+ */
+int hash_bench(ulong len);
+
+/**
+ * hash_lookup_algo() - Look up the hash_algo struct for an algorithm
+ *
+ * The function returns the pointer to the struct or -EPROTONOSUPPORT if the
+ * algorithm is not available.
+ *
+ * @algo_name:		Hash algorithm to look up
+ * @algop:		Pointer to the hash_algo struct if found
+ *
+ * @return 0 if ok, -EPROTONOSUPPORT for an unknown algorithm.
+ */
+int hash_lookup_algo(const char *algo_name, struct hash_algo **algop);
+
+#ifdef CONFIG_HASH_LOAD
+/**
+ * hash_load_start() - Start hashing data as a loader stores it
+ *
+ * If the environment variable "loadhash" names a hash algorithm, the data
+ * of the following load is hashed while it arrives. Loaders pass every
+ * piece they store to hash_load_update(); hash_load_finish() hashes
+ * whatever was not passed, prints the digest and stores it in the
+ * environment variable "filehash".
+ *
+ * @return 0 if ok (also when "loadhash" is not set), -EPROTONOSUPPORT for
+ * an unknown algorithm.
+ */
+int hash_load_start(void);
+
+/**
+ * hash_load_update() - Feed a piece of the data being loaded
+ *
+ * Pieces must arrive in order; anything that would leave a gap is left
+ * for hash_load_finish(), as are pieces the loader never passes.
+ *
+ * @offset:	Offset of the piece from the start of the load
+ * @buf:	Piece of data
+ * @len:	Length of the piece
+ */
+void hash_load_update(ulong offset, const void *buf, ulong len);
+
+/**
+ * hash_load_busy() - Check whether pieces passed on get hashed
+ *
+ * @return non-zero if hash_load_update() hashes pieces as they come, 0 if
+ * nothing is being hashed or the algorithm can only hash in one go.
+ */
+int hash_load_busy(void);
+
+/**
+ * hash_load_finish() - Complete the hash of a load
+ *
+ * @addr:	Address the data was loaded to
+ * @len:	Length of the data loaded
+ */
+void hash_load_finish(ulong addr, ulong len);
+#else
+static inline int hash_load_start(void)
+{
+	return 0;
+}
+
+static inline void hash_load_update(ulong offset, const void *buf, ulong len)
+{
+}
+
+static inline int hash_load_busy(void)
+{
+	return 0;
+}
+
+static inline void hash_load_finish(ulong addr, ulong len)
+{
+}
+#endif
+
 #endif
@@ -0,0 +1,91 @@
+/*
+ * Writing Android sparse images to block devices
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __IMAGE_SPARSE_H
+#define __IMAGE_SPARSE_H
+
+#include <part.h>
+#include <sparse_format.h>
+#include <asm/unaligned.h>
+
+/* Where a sparse image goes */
+struct sparse_storage {
+	lbaint_t	blksz;		/* device block size in bytes */
+	lbaint_t	start;		/* first device block of the area */
+	lbaint_t	size;		/* device blocks in the area */
+	void		*priv;
+
+	/* Write @blkcnt blocks from @buffer at @blk; returns blocks written */
+	lbaint_t	(*write)(struct sparse_storage *info, lbaint_t blk,
+				 lbaint_t blkcnt, const void *buffer);
+};
+
+/* Decoder state, so an image can be fed in pieces as it arrives */
+struct sparse_stream {
+	struct sparse_storage *info;
+	int		state;
+	int		err;
+
+	sparse_header_t	hdr;
+	u8		stage[sizeof(sparse_header_t)];
+	uint		staged;		/* bytes in stage[] */
+	uint		need;		/* bytes stage[] has to reach */
+	ulong		skip;		/* bytes of input to drop */
+
+	u32		chunks_left;
+	u32		chunk_type;
+	lbaint_t	chunk_blks;	/* device blocks in this chunk */
+	ulong		left;		/* data bytes of the chunk to come */
+
+	lbaint_t	blk;		/* next device block, from start */
+	u8		*part;		/* a device block of raw data */
+	uint		part_len;
+	u8		*fill;		/* a run of fill values */
+	lbaint_t	fill_blks;	/* device blocks in fill[] */
+	u32		fill_val;
+
+	lbaint_t	written;	/* device blocks written */
+	lbaint_t	skipped;	/* device blocks left alone */
+};
+
+static inline int is_sparse_image(const void *buf)
+{
+	return get_unaligned_le32(buf) == SPARSE_HEADER_MAGIC;
+}
+
+/**
+ * sparse_stream_start() - get ready to write a sparse image
+ *
+ * @s:		decoder state
+ * @info:	the area to write to
+ */
+void sparse_stream_start(struct sparse_stream *s, struct sparse_storage *info);
+
+/**
+ * sparse_stream_write() - decode the next piece of a sparse image
+ *
+ * Raw data is written from @data as far as it fills whole device blocks,
+ * fill chunks are written from a buffer of repeated values and don't
+ * care chunks are skipped. Anything after the last chunk is ignored, so
+ * callers that do not know the image size may pass a larger @len.
+ *
+ * @s:		decoder state
+ * @data:	next bytes of the image
+ * @len:	number of bytes at @data
+ * @return 0 if OK, -EINVAL for a bad image, -ENOSPC if it does not fit,
+ * -ENOMEM or -EIO
+ */
+int sparse_stream_write(struct sparse_stream *s, const void *data, ulong len);
+
+/**
+ * sparse_stream_finish() - check the image was complete and clean up
+ *
+ * @s:		decoder state
+ * @return 0 if the whole image was written, else the first error
+ */
+int sparse_stream_finish(struct sparse_stream *s);
+
+#endif /* __IMAGE_SPARSE_H */
@@ -224,6 +224,7 @@ struct lmb;
 #define IH_COMP_BZIP2		2	/* bzip2 Compression Used	*/
 #define IH_COMP_LZMA		3	/* lzma  Compression Used	*/
 #define IH_COMP_LZO		4	/* lzo   Compression Used	*/
+#define IH_COMP_LZ4		5	/* lz4   Compression Used	*/
 
 #define IH_MAGIC	0x27051956	/* Image Magic Number		*/
 #define IH_NMLEN		32	/* Image Name Length		*/
@@ -486,6 +487,45 @@ int boot_get_cmdline(struct lmb *lmb, ulong *cmd_start, ulong *cmd_end);
 #ifdef CONFIG_SYS_BOOT_GET_KBD
 int boot_get_kbd(struct lmb *lmb, bd_t **kbd);
 #endif /* CONFIG_SYS_BOOT_GET_KBD */
+
+#ifdef CONFIG_IMAGE_STREAM
+/*
+ * Loaders call these so that a gzip compressed legacy kernel image is
+ * uncompressed while it is being loaded (if env "loadunzip" is set):
+ * start before storing anything at @addr, update each time a piece of
+ * the file has been stored, finish with the file's length.
+ */
+void image_stream_start(ulong addr);
+void image_stream_update(ulong offset, const void *buf, ulong len);
+void image_stream_finish(ulong len);
+
+/* Returns 1 while the data stored so far may still be a kernel to stream */
+int image_stream_busy(void);
+
+/**
+ * image_stream_take() - claim a kernel uncompressed while loading
+ *
+ * @hdr:	legacy image header bootm is about to load
+ * @lenp:	returns the uncompressed length
+ * @return 1 if @hdr was uncompressed to its load address and is still
+ * there intact, 0 if bootm has to uncompress it
+ */
+int image_stream_take(const image_header_t *hdr, ulong *lenp);
+#else
+static inline void image_stream_start(ulong addr) {}
+static inline void image_stream_update(ulong offset, const void *buf,
+				       ulong len) {}
+static inline void image_stream_finish(ulong len) {}
+static inline int image_stream_busy(void)
+{
+	return 0;
+}
+static inline int image_stream_take(const image_header_t *hdr,
+				    ulong *lenp)
+{
+	return 0;
+}
+#endif
 #endif /* !USE_HOSTCC */
 
 /*******************************************************************/
@@ -785,6 +825,11 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 int fit_image_verify(const void *fit, int noffset);
 int fit_config_verify(const void *fit, int conf_noffset);
 int fit_all_image_verify(const void *fit);
+#if defined(CONFIG_SMP_JOBS) && !defined(USE_HOSTCC)
+void fit_verify_reset(void);
+#else
+static inline void fit_verify_reset(void) {}
+#endif
 int fit_image_check_os(const void *fit, int noffset, uint8_t os);
 int fit_image_check_arch(const void *fit, int noffset, uint8_t arch);
 int fit_image_check_type(const void *fit, int noffset, uint8_t type);
@@ -0,0 +1,30 @@
+/*
+ * LZ4 decompression
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __LZ4_H__
+#define __LZ4_H__
+
+/**
+ * ulz4fn() - decompress LZ4 data
+ *
+ * Handles one or more LZ4 frames as written by the lz4 tool, including
+ * skippable frames, as well as the older "legacy" format used for Linux
+ * kernel images (lz4 -l). Block and content checksums are not checked;
+ * the image around the data is expected to carry its own hash.
+ * Up to seven bytes of @dst past the uncompressed data may be written.
+ *
+ * @src:	compressed data
+ * @srcn:	length of @src, or ~0 if not known (frame format only)
+ * @dst:	output buffer
+ * @dstn:	on entry the size of @dst (or ~0), on return the uncompressed
+ *		length
+ *
+ * Return: 0 on success, -ENOSPC if @dst is too small, -EINVAL if the data
+ * is not valid LZ4 or uses features that are not supported (dictionaries).
+ */
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+#endif /* __LZ4_H__ */
@@ -41,6 +41,7 @@ typedef struct entry {
 
 /* Opaque type for internal use.  */
 struct _ENTRY;
+struct hlazy;
 
 /*
  * Family of hash table handling functions.  The functions also
@@ -62,6 +63,8 @@ struct hsearch_data {
  */
 	int (*change_ok)(const ENTRY *__item, const char *newval, enum env_op,
 		int flag);
+	/* Entries not imported yet, see himport_lazy_r() */
+	struct hlazy *lazy;
 };
 
 /* Create a new hashing table which will at most contain NEL elements.  */
@@ -104,6 +107,22 @@ extern int himport_r(struct hsearch_data *__htab,
 		     const char *__env, size_t __size, const char __sep,
 		     int __flag, int nvars, char * const vars[]);
 
+/*
+ * Like himport_r() for '\0' separated data, but only index the entries;
+ * each is imported when first looked up (CONFIG_ENV_LAZY_IMPORT).
+ */
+extern int himport_lazy_r(struct hsearch_data *__htab,
+		     const char *__env, size_t __size, int __flag);
+
+/* Import all entries still pending from himport_lazy_r() */
+#ifdef CONFIG_ENV_LAZY_IMPORT
+extern void himport_finish_r(struct hsearch_data *__htab);
+#else
+static inline void himport_finish_r(struct hsearch_data *__htab)
+{
+}
+#endif
+
 /* Walk the whole table calling the callback on each element */
 extern int hwalk_r(struct hsearch_data *__htab, int (*callback)(ENTRY *));
 
@@ -45,6 +45,9 @@ typedef struct
 }
 sha1_context;
 
+/* Compresses one 64 byte block of input into ctx->state */
+typedef void (*sha1_block_fn)(sha1_context *ctx, const unsigned char data[64]);
+
 /**
  * \brief	   SHA-1 context setup
  *
@@ -91,6 +94,19 @@ void sha1_csum(const unsigned char *input, unsigned int ilen,
 void sha1_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/*
+ * Variants of sha1_update(), sha1_finish() and sha1_csum_wd() which hand
+ * each 64 byte block to @process rather than to the generic C compression
+ * function, for architecture specific implementations.
+ */
+void sha1_update_fn(sha1_context *ctx, const unsigned char *input,
+		    unsigned int ilen, sha1_block_fn process);
+void sha1_finish_fn(sha1_context *ctx, unsigned char output[20],
+		    sha1_block_fn process);
+void sha1_csum_wd_fn(const unsigned char *input, unsigned int ilen,
+		     unsigned char *output, unsigned int chunk_sz,
+		     sha1_block_fn process);
+
 /**
  * \brief	   Output = HMAC-SHA-1( input buffer, hmac key )
  *
@@ -12,6 +12,9 @@ typedef struct {
 	uint8_t buffer[64];
 } sha256_context;
 
+/* Compresses one 64 byte block of input into ctx->state */
+typedef void (*sha256_block_fn)(sha256_context *ctx, const uint8_t data[64]);
+
 void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
@@ -19,4 +22,17 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/*
+ * Variants of the above which hand each 64 byte block to @process rather
+ * than to the generic C compression function, for architecture specific
+ * implementations.
+ */
+void sha256_update_fn(sha256_context *ctx, const uint8_t *input,
+		      uint32_t length, sha256_block_fn process);
+void sha256_finish_fn(sha256_context *ctx, uint8_t digest[SHA256_SUM_LEN],
+		      sha256_block_fn process);
+void sha256_csum_wd_fn(const unsigned char *input, unsigned int ilen,
+		       unsigned char *output, unsigned int chunk_sz,
+		       sha256_block_fn process);
+
 #endif /* _SHA256_H */
@@ -0,0 +1,32 @@
+/*
+ * SHA-1 and SHA-256 using NEON for the message schedule (ARMv7)
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __SHA_NEON_H
+#define __SHA_NEON_H
+
+/**
+ * Compress one 64 byte block, for use with the sha*_fn() helpers
+ *
+ * @param ctx		Context from sha256_starts() / sha1_starts()
+ * @param data		Block to process, need not be aligned
+ */
+void sha256_neon_block(sha256_context *ctx, const uint8_t data[64]);
+void sha1_neon_block(sha1_context *ctx, const unsigned char data[64]);
+
+/**
+ * Computes the hash of a buffer, drop-in for sha256_csum_wd() and
+ * sha1_csum_wd()
+ *
+ * @param input		A pointer to the input buffer
+ * @param ilen		Byte length of input buffer
+ * @param output	A pointer to the output buffer, 32 / 20 bytes
+ * @param chunk_sz	Reset the watchdog after this many bytes
+ */
+void sha256_neon_csum_wd(const unsigned char *input, unsigned int ilen,
+			 unsigned char *output, unsigned int chunk_sz);
+void sha1_neon_csum_wd(const unsigned char *input, unsigned int ilen,
+		       unsigned char *output, unsigned int chunk_sz);
+
+#endif /* __SHA_NEON_H */
@@ -0,0 +1,73 @@
+/*
+ * Run a single job on a secondary CPU while the boot CPU carries on.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _SMP_JOB_H_
+#define _SMP_JOB_H_
+
+typedef void (*smp_job_func)(void *arg);
+
+#ifdef CONFIG_SMP_JOBS
+/**
+ * smp_job_submit() - hand a job to the secondary CPU
+ *
+ * @func:	function to run on the secondary CPU
+ * @arg:	argument passed to @func
+ * @in:		memory @func reads (cleaned from the cache before the job
+ *		starts), may be NULL
+ * @in_len:	length of @in
+ * @out:	memory @func writes; must start and end on a cache line
+ *		boundary since it is invalidated by smp_job_wait()
+ * @out_len:	length of @out
+ *
+ * Only one job can be outstanding at a time. @func runs without
+ * console or interrupts and must not call into drivers; it is meant
+ * for pure computation such as hashing.
+ * Anything @func needs from @arg must lie within @in or @out.
+ *
+ * Return: 0 if the job was queued, -EBUSY if a job is still pending.
+ */
+int smp_job_submit(smp_job_func func, void *arg, const void *in,
+		   size_t in_len, void *out, size_t out_len);
+
+/**
+ * smp_job_wait() - wait for the job queued by smp_job_submit()
+ *
+ * If the secondary CPU never picks the job up it is shut down and the
+ * job is run on the calling CPU instead, so on return the job has
+ * always completed and @out is valid.
+ *
+ * Return: 0, or -ENOENT if no job was pending.
+ */
+int smp_job_wait(void);
+
+/**
+ * smp_job_stop() - park the secondary CPU
+ *
+ * Waits for a pending job, then puts the secondary back into the
+ * state the OS expects it in. Called when there is no more work for
+ * it and before control leaves U-Boot; the next smp_job_submit()
+ * starts it again.
+ */
+void smp_job_stop(void);
+#else
+static inline int smp_job_submit(smp_job_func func, void *arg,
+				 const void *in, size_t in_len,
+				 void *out, size_t out_len)
+{
+	return -ENOSYS;
+}
+
+static inline int smp_job_wait(void)
+{
+	return -ENOENT;
+}
+
+static inline void smp_job_stop(void)
+{
+}
+#endif
+
+#endif /* _SMP_JOB_H_ */
@@ -0,0 +1,38 @@
+/*
+ * Android sparse image format, as written by img2simg and make_ext4fs -s
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __SPARSE_FORMAT_H
+#define __SPARSE_FORMAT_H
+
+/* All fields are little endian */
+typedef struct sparse_header {
+	__le32	magic;		/* SPARSE_HEADER_MAGIC */
+	__le16	major_version;	/* images with a newer major are refused */
+	__le16	minor_version;
+	__le16	file_hdr_sz;	/* 28 bytes in version 1.0 */
+	__le16	chunk_hdr_sz;	/* 12 bytes in version 1.0 */
+	__le32	blk_sz;		/* output block size, a multiple of 4 */
+	__le32	total_blks;	/* blocks in the output image */
+	__le32	total_chunks;	/* chunks in this file */
+	__le32	image_checksum;	/* CRC32 of the output, 0 if not set */
+} sparse_header_t;
+
+#define SPARSE_HEADER_MAGIC	0xed26ff3a
+#define SPARSE_HEADER_MAJOR_VER	1
+
+#define CHUNK_TYPE_RAW		0xcac1	/* blk_sz * chunk_sz bytes of data */
+#define CHUNK_TYPE_FILL		0xcac2	/* a 4 byte value to repeat */
+#define CHUNK_TYPE_DONT_CARE	0xcac3	/* no data, blocks left as they are */
+#define CHUNK_TYPE_CRC32	0xcac4	/* CRC32 of the output so far */
+
+typedef struct chunk_header {
+	__le16	chunk_type;	/* CHUNK_TYPE_* */
+	__le16	reserved1;
+	__le32	chunk_sz;	/* in output blocks */
+	__le32	total_sz;	/* in bytes, header and data */
+} chunk_header_t;
+
+#endif /* __SPARSE_FORMAT_H */
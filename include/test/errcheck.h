@@ -0,0 +1,28 @@
+/*
+ * Helpers shared by the sandbox test_* commands under test/
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TEST_ERRCHECK_H
+#define __TEST_ERRCHECK_H
+
+/*
+ * Check a condition; if it does not hold, report it, set 'ret' to 1 and
+ * go to the 'out' label of the calling function to clean up.
+ */
+#define errcheck(statement) if (!(statement)) { \
+	fprintf(stderr, "\tFailed: %s\n", #statement); \
+	ret = 1; \
+	goto out; \
+}
+
+/* Print the overall result of test @name and pass @ret on */
+static inline int test_report(const char *name, int ret)
+{
+	printf("%s %s\n", name, ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+#endif /* __TEST_ERRCHECK_H */
@@ -162,6 +162,37 @@ int submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 int submit_int_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, int interval);
 
+#ifdef CONFIG_USB_EHCI_BULK_QUEUE
+/* A bulk transfer queued with submit_bulk_queue() */
+struct bulk_req {
+	void *buffer;
+	int length;
+	/* private to the host controller driver */
+	unsigned long pipe;
+	int first;			/* first qTD */
+	int count;			/* number of qTDs */
+	int next;			/* first qTD not seen completed */
+	int act_len;
+	int seq;
+};
+
+/*
+ * Queue @nreq transfers on @pipe, all of them or none. The controller
+ * starts on them right away, after anything already queued on the pipe.
+ * They have to be waited for in the order they were queued.
+ */
+int submit_bulk_queue(struct usb_device *dev, unsigned long pipe,
+		      struct bulk_req *req, int nreq);
+/*
+ * Wait for a queued transfer and set dev->status and dev->act_len.
+ * Returns 0 on success. On failure, whatever else was queued on the
+ * pipe is dropped.
+ */
+int wait_bulk_queue(struct usb_device *dev, struct bulk_req *req);
+/* Drop all transfers queued on @pipe */
+void cancel_bulk_queue(struct usb_device *dev, unsigned long pipe);
+#endif
+
 /* Defines */
 #define USB_UHCI_VEND_ID	0x8086
 #define USB_UHCI_DEV_ID		0x7112
@@ -413,6 +444,12 @@ struct usb_hub_descriptor {
 struct usb_hub_device {
 	struct usb_device *pusb_dev;
 	struct usb_hub_descriptor desc;
+#ifdef CONFIG_USB_HUB_CONCURRENT_SCAN
+	/* Bring-up of each port, see usb_hub_scan() */
+	unsigned char port_state[USB_MAXCHILDREN];
+	unsigned short port_status[USB_MAXCHILDREN];
+	ulong port_timer[USB_MAXCHILDREN];	/* get_timer() at last step */
+#endif
 };
 
 int usb_hub_probe(struct usb_device *dev, int ifnum);
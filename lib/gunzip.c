@@ -11,6 +11,7 @@
 #include <image.h>
 #include <malloc.h>
 #include <u-boot/zlib.h>
+#include <asm/errno.h>
 
 #define	ZALLOC_ALIGNMENT	16
 #define HEAD_CRC		2
@@ -37,28 +38,51 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/*
+ * Returns the length of the gzip header at src, -EINVAL if it is not one
+ * we can handle or -EAGAIN if it does not fit in the len bytes given.
+ */
+int gzip_parse_header(const unsigned char *src, unsigned long len)
 {
 	int i, flags;
 
+	if (len < 10)
+		return -EAGAIN;
+
 	/* skip header */
 	i = 10;
 	flags = src[3];
-	if (src[2] != DEFLATED || (flags & RESERVED) != 0) {
-		puts ("Error: Bad gzipped data\n");
-		return (-1);
-	}
-	if ((flags & EXTRA_FIELD) != 0)
+	if (src[2] != DEFLATED || (flags & RESERVED) != 0)
+		return -EINVAL;
+	if ((flags & EXTRA_FIELD) != 0) {
+		if (len < 12)
+			return -EAGAIN;
 		i = 12 + src[10] + (src[11] << 8);
+	}
 	if ((flags & ORIG_NAME) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & COMMENT) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len)
+		return -EAGAIN;
+
+	return i;
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	int i;
+
+	i = gzip_parse_header(src, *lenp);
+	if (i == -EINVAL) {
+		puts ("Error: Bad gzipped data\n");
+		return (-1);
+	}
+	if (i < 0) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
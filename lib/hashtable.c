@@ -66,6 +66,19 @@ typedef struct _ENTRY {
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
 
+#ifdef CONFIG_ENV_LAZY_IMPORT
+static void hlazy_import(struct hsearch_data *htab, const char *key);
+static void hlazy_free(struct hsearch_data *htab);
+#else
+static inline void hlazy_import(struct hsearch_data *htab, const char *key)
+{
+}
+
+static inline void hlazy_free(struct hsearch_data *htab)
+{
+}
+#endif
+
 /*
  * hcreate()
  */
@@ -146,6 +159,8 @@ void hdestroy_r(struct hsearch_data *htab)
 		return;
 	}
 
+	hlazy_free(htab);
+
 	/* free used memory */
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
@@ -204,6 +219,8 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
+	himport_finish_r(htab);
+
 	for (idx = last_idx + 1; idx < htab->size; ++idx) {
 		if (htab->table[idx].used <= 0)
 			continue;
@@ -278,6 +295,10 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	unsigned int first_deleted = 0;
 	int ret;
 
+	/* Bring in the entry first if it is still waiting to be imported */
+	if (htab->lazy)
+		hlazy_import(htab, item.key);
+
 	/* Compute an value for the given string. Perhaps use a better method. */
 	hval = len;
 	count = len;
@@ -602,6 +623,8 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		return (-1);
 	}
 
+	himport_finish_r(htab);
+
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, "
 		"size = %zu\n", htab, htab->size, htab->filled, size);
 	/*
@@ -739,6 +762,18 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
 	return res;
 }
 
+static int hcreate_env(struct hsearch_data *htab, size_t size)
+{
+	int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
+
+	if (nent > CONFIG_ENV_MAX_ENTRIES)
+		nent = CONFIG_ENV_MAX_ENTRIES;
+
+	debug("Create Hash Table: N=%d\n", nent);
+
+	return hcreate_r(nent, htab);
+}
+
 /*
  * Import linearized data into hash table.
  *
@@ -809,6 +844,9 @@ int himport_r(struct hsearch_data *htab,
 			hdestroy_r(htab);
 	}
 
+	if (flag & H_NOCLEAR)
+		himport_finish_r(htab);	/* or they would override the new data */
+
 	/*
 	 * Create new hash table (if needed).  The computation of the hash
 	 * table size is based on heuristics: in a sample of some 70+
@@ -827,18 +865,9 @@ int himport_r(struct hsearch_data *htab,
 	 * be overwritten in the board config file if needed.
 	 */
 
-	if (!htab->table) {
-		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
-
-		if (nent > CONFIG_ENV_MAX_ENTRIES)
-			nent = CONFIG_ENV_MAX_ENTRIES;
-
-		debug("Create Hash Table: N=%d\n", nent);
-
-		if (hcreate_r(nent, htab) == 0) {
-			free(data);
-			return 0;
-		}
+	if (!htab->table && !hcreate_env(htab, size)) {
+		free(data);
+		return 0;
 	}
 
 	/* Parse environment; allow for '\0' and 'sep' as separators */
@@ -937,6 +966,206 @@ int himport_r(struct hsearch_data *htab,
 	return 1;		/* everything OK */
 }
 
+#ifdef CONFIG_ENV_LAZY_IMPORT
+/*
+ * himport_lazy_r()
+ */
+
+/*
+ * A lazy import keeps a copy of the '\0' separated "name=value" list and
+ * an index of it: an open addressing table holding the offset (plus one)
+ * of the last entry for each name. Nothing is parsed beyond the names.
+ * hsearch_r() imports an entry the first time its name is looked up, so
+ * it goes through the same flags checks and callbacks as with himport_r(),
+ * just later. Operations that need every entry import the rest first.
+ */
+#define HLAZY_DONE	(~0U)	/* entry imported, keep probing past it */
+
+struct hlazy {
+	char *data;		/* copy of the imported list */
+	unsigned int mask;	/* number of slots - 1 */
+	unsigned int pending;	/* entries not imported yet */
+	int busy;		/* nesting of hlazy_import_slot() */
+	int flag;		/* himport_r() flag to import them with */
+	unsigned int slot[];
+};
+
+static unsigned int hlazy_hash(const char *name, size_t len)
+{
+	unsigned int hval = len;
+
+	while (len--)
+		hval = hval * 31 + name[len];
+
+	return hval;
+}
+
+/* Find the slot of a name, or the empty slot where it would go */
+static unsigned int *hlazy_find(struct hlazy *lz, const char *name,
+				size_t len)
+{
+	unsigned int i = hlazy_hash(name, len);
+	const char *p;
+
+	for (;; i++) {
+		unsigned int *slot = &lz->slot[i & lz->mask];
+
+		if (!*slot)
+			return slot;
+		if (*slot == HLAZY_DONE)
+			continue;
+		p = lz->data + *slot - 1;
+		if (!strncmp(p, name, len) && (p[len] == '=' || !p[len]))
+			return slot;
+	}
+}
+
+static void hlazy_free(struct hsearch_data *htab)
+{
+	if (!htab->lazy)
+		return;
+
+	free(htab->lazy->data);
+	free(htab->lazy);
+	htab->lazy = NULL;
+}
+
+static void hlazy_import_slot(struct hsearch_data *htab, unsigned int *slot)
+{
+	struct hlazy *lz = htab->lazy;
+	char *name, *value, *dp, *sp;
+	ENTRY e, *rv;
+
+	name = lz->data + *slot - 1;
+	*slot = HLAZY_DONE;
+	lz->pending--;
+
+	/* parse as himport_r() does; "name" and "name=" are deletions */
+	for (dp = name; *dp != '=' && *dp; ++dp)
+		;
+	if (*dp == '=' && *(dp + 1)) {
+		*dp++ = '\0';
+		for (value = sp = dp; *dp; ++dp) {
+			if ((*dp == '\\') && *(dp + 1))
+				++dp;
+			*sp++ = *dp;
+		}
+		*sp = '\0';
+
+		/* entering it may look up others, e.g. ".flags" */
+		e.key = name;
+		e.data = value;
+		lz->busy++;
+		hsearch_r(e, ENTER, &rv, htab, lz->flag);
+		lz->busy--;
+		if (rv == NULL)
+			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
+				name, value);
+	}
+
+	if (!lz->pending && !lz->busy)
+		hlazy_free(htab);
+}
+
+static void hlazy_import(struct hsearch_data *htab, const char *key)
+{
+	unsigned int *slot = hlazy_find(htab->lazy, key, strlen(key));
+
+	if (*slot)
+		hlazy_import_slot(htab, slot);
+}
+
+void himport_finish_r(struct hsearch_data *htab)
+{
+	unsigned int i;
+
+	for (i = 0; htab->lazy && i <= htab->lazy->mask; i++) {
+		unsigned int *slot = &htab->lazy->slot[i];
+
+		if (*slot && *slot != HLAZY_DONE)
+			hlazy_import_slot(htab, slot);
+	}
+}
+
+int himport_lazy_r(struct hsearch_data *htab, const char *env, size_t size,
+		   int flag)
+{
+	struct hlazy *lz;
+	const char *dp, *end = env + size;
+	unsigned int n, nslots;
+	unsigned int *slot;
+	size_t len, used;
+	char *name;
+
+	if (htab == NULL) {
+		__set_errno(EINVAL);
+		return 0;
+	}
+	if (htab->table)
+		hdestroy_r(htab);
+
+	/* count the entries; the list ends at an empty one */
+	for (dp = env, n = 0; dp < end && *dp; n++)
+		dp += strnlen(dp, end - dp) + 1;
+	used = dp < end ? dp - env : size;
+
+	for (nslots = 16; nslots < 2 * n; nslots <<= 1)
+		;
+	lz = calloc(1, sizeof(*lz) + nslots * sizeof(lz->slot[0]));
+	if (lz)
+		lz->data = malloc(used + 1);
+	if (!lz || !lz->data) {
+		free(lz);
+		debug("himport_lazy_r: can't malloc %zu bytes\n", used);
+		__set_errno(ENOMEM);
+		return 0;
+	}
+	memcpy(lz->data, env, used);
+	lz->data[used] = '\0';
+	lz->mask = nslots - 1;
+	lz->flag = flag;
+
+	for (name = lz->data; name < lz->data + used; name += len + 1) {
+		len = strlen(name);
+
+		/* skip leading white space and comment lines */
+		while (isblank(*name)) {
+			++name;
+			--len;
+		}
+		if (*name == '#' || !*name)
+			continue;
+
+		for (n = 0; name[n] != '=' && name[n]; n++)
+			;
+		if (!n) {
+			debug("INSERT: unable to use an empty key\n");
+			free(lz->data);
+			free(lz);
+			__set_errno(EINVAL);
+			return 0;
+		}
+
+		/* a later entry for the same name replaces an earlier one */
+		slot = hlazy_find(lz, name, n);
+		if (!*slot)
+			lz->pending++;
+		*slot = name - lz->data + 1;
+	}
+
+	if (!hcreate_env(htab, size)) {
+		free(lz->data);
+		free(lz);
+		return 0;
+	}
+	htab->lazy = lz;
+	if (!lz->pending)
+		hlazy_free(htab);
+
+	return 1;
+}
+#endif /* CONFIG_ENV_LAZY_IMPORT */
+
 /*
  * hwalk_r()
  */
@@ -944,6 +1173,8 @@ int himport_r(struct hsearch_data *htab,
 /*
  * Walk all of the entries in the hash, calling the callback for each one.
  * this allows some generic operation to be performed on each element.
+ * Entries still pending from himport_lazy_r() are not walked; call
+ * himport_finish_r() first where they matter.
  */
 int hwalk_r(struct hsearch_data *htab, int (*callback)(ENTRY *))
 {
@@ -0,0 +1,292 @@
+/*
+ * LZ4 decompression, frame and legacy formats
+ *
+ * An LZ4 block is a series of sequences: a token whose high nibble is the
+ * number of literals and whose low nibble is the match length minus four
+ * (a nibble of 15 is extended by following bytes up to and including the
+ * first one that is not 255), the literals, then a two byte little endian
+ * offset back into the output. The last sequence has literals only.
+ *
+ * The output is written straight to its final place and matches are
+ * copied from there, so linked blocks work without any window buffer.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <lz4.h>
+#include <asm/errno.h>
+#include <asm/unaligned.h>
+
+#define LZ4_MAGIC		0x184d2204
+#define LZ4_LEGACY_MAGIC	0x184c2102
+#define LZ4_SKIP_MAGIC		0x184d2a50	/* low nibble is free */
+#define LZ4_SKIP_MASK		0xfffffff0
+
+/* Frame descriptor flags */
+#define LZ4_FLG_VERSION_MASK	0xc0
+#define LZ4_FLG_VERSION		0x40
+#define LZ4_FLG_BLOCK_CSUM	0x10
+#define LZ4_FLG_CONTENT_SIZE	0x08
+#define LZ4_FLG_CONTENT_CSUM	0x04
+#define LZ4_FLG_DICT_ID		0x01
+
+#define LZ4_BLOCK_UNCOMPRESSED	0x80000000
+
+#define LZ4_MIN_MATCH		4
+
+/*
+ * Most literal runs and matches are short. When there is room to spare,
+ * copy them in fixed 8 byte steps, which the compiler turns into plain
+ * loads and stores, and let the last step write past the end; the next
+ * sequence overwrites the excess.
+ */
+#define LZ4_COPY		8
+
+static inline void lz4_wildcopy(u8 *op, const u8 *ip, size_t len)
+{
+	u8 *end = op + len;
+
+	do {
+		memcpy(op, ip, LZ4_COPY);
+		op += LZ4_COPY;
+		ip += LZ4_COPY;
+	} while (op < end);
+}
+
+/* Read a length extended by 255 bytes; returns 0 on success */
+static inline int lz4_get_len(const u8 **ipp, const u8 *iend, size_t *lenp)
+{
+	const u8 *ip = *ipp;
+	size_t len = *lenp;
+	u8 b;
+
+	do {
+		if (ip >= iend)
+			return -1;
+		b = *ip++;
+		len += b;
+	} while (b == 255);
+
+	*ipp = ip;
+	*lenp = len;
+
+	return 0;
+}
+
+/*
+ * Decode one block of @in_len bytes to *@opp. @base is the start of the
+ * frame's output, the furthest back a match may reach.
+ */
+static int lz4_block(const u8 *ip, size_t in_len, u8 *base, u8 **opp,
+		     u8 *oend)
+{
+	const u8 *iend = ip + in_len;
+	u8 *op = *opp;
+	const u8 *match;
+	size_t len, off;
+	u8 token;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		len = token >> 4;
+		if (len == 15 && lz4_get_len(&ip, iend, &len))
+			return -EINVAL;
+		if (len > iend - ip)
+			return -EINVAL;
+		if (len > oend - op)
+			return -ENOSPC;
+		if (len + LZ4_COPY > iend - ip || len + LZ4_COPY > oend - op)
+			memcpy(op, ip, len);
+		else
+			lz4_wildcopy(op, ip, len);
+		op += len;
+		ip += len;
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -EINVAL;
+		off = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (!off || off > op - base)
+			return -EINVAL;
+
+		len = token & 15;
+		if (len == 15 && lz4_get_len(&ip, iend, &len))
+			return -EINVAL;
+		len += LZ4_MIN_MATCH;
+		if (len > oend - op)
+			return -ENOSPC;
+
+		match = op - off;
+		if (off >= LZ4_COPY && len + LZ4_COPY <= oend - op) {
+			lz4_wildcopy(op, match, len);
+			op += len;
+		} else if (off >= len) {
+			memcpy(op, match, len);
+			op += len;
+		} else {
+			/* Overlapping: repeats the last @off bytes */
+			while (len--)
+				*op++ = *match++;
+		}
+	}
+
+	*opp = op;
+
+	return 0;
+}
+
+/* Decode an LZ4 frame; *@ipp points past the magic number */
+static int lz4_frame(const u8 **ipp, const u8 *iend, u8 **opp, u8 *oend)
+{
+	const u8 *ip = *ipp;
+	u8 *base = *opp, *op = *opp;
+	size_t hlen, size;
+	u32 block;
+	u8 flg;
+	int ret;
+
+	if (iend - ip < 3)
+		return -EINVAL;
+	flg = ip[0];
+	if ((flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION ||
+	    (flg & LZ4_FLG_DICT_ID))
+		return -EINVAL;
+
+	/* FLG, BD, optional content size, header checksum */
+	hlen = 3;
+	if (flg & LZ4_FLG_CONTENT_SIZE) {
+		hlen += 8;
+		if (iend - ip < hlen)
+			return -EINVAL;
+		if (get_unaligned_le32(ip + 6) ||
+		    get_unaligned_le32(ip + 2) > oend - op)
+			return -ENOSPC;
+	}
+	ip += hlen;
+
+	for (;;) {
+		if (iend - ip < 4)
+			return -EINVAL;
+		block = get_unaligned_le32(ip);
+		ip += 4;
+		if (!block)
+			break;
+
+		size = block & ~LZ4_BLOCK_UNCOMPRESSED;
+		if (size > iend - ip)
+			return -EINVAL;
+		if (block & LZ4_BLOCK_UNCOMPRESSED) {
+			if (size > oend - op)
+				return -ENOSPC;
+			memcpy(op, ip, size);
+			op += size;
+		} else {
+			ret = lz4_block(ip, size, base, &op, oend);
+			if (ret)
+				return ret;
+		}
+		ip += size;
+
+		if (flg & LZ4_FLG_BLOCK_CSUM)
+			ip += 4;
+	}
+
+	if (flg & LZ4_FLG_CONTENT_CSUM)
+		ip += 4;
+	if (ip > iend)
+		return -EINVAL;
+
+	*ipp = ip;
+	*opp = op;
+
+	return 0;
+}
+
+/*
+ * Decode a legacy frame: compressed blocks of up to 8MB output each, until
+ * the end of the input or the next magic number. Kernel builds append the
+ * uncompressed size as a four byte trailer, which ulz4fn() then ignores.
+ */
+static int lz4_legacy(const u8 **ipp, const u8 *iend, u8 **opp, u8 *oend)
+{
+	const u8 *ip = *ipp;
+	u8 *op = *opp;
+	u32 size;
+	int ret;
+
+	while (iend - ip > 4) {
+		size = get_unaligned_le32(ip);
+		if (size == LZ4_MAGIC || size == LZ4_LEGACY_MAGIC)
+			break;
+		ip += 4;
+		if (size > iend - ip)
+			return -EINVAL;
+		/* Blocks are independent of each other */
+		ret = lz4_block(ip, size, op, &op, oend);
+		if (ret)
+			return ret;
+		ip += size;
+	}
+
+	*ipp = ip;
+	*opp = op;
+
+	return 0;
+}
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *ip = src, *iend;
+	u8 *op = dst, *oend;
+	size_t room = *dstn;
+	u32 magic;
+	int frames = 0;
+	int ret;
+
+	/*
+	 * Callers that do not know a length pass ~0 and rely on the end
+	 * marks; keep the pointer differences below from overflowing.
+	 */
+	srcn = min(srcn, (size_t)((uintptr_t)-1 - (uintptr_t)src));
+	srcn = min(srcn, ~(size_t)0 >> 1);
+	iend = ip + srcn;
+	room = min(room, (size_t)((uintptr_t)-1 - (uintptr_t)dst));
+	room = min(room, ~(size_t)0 >> 1);
+	oend = op + room;
+
+	while (iend - ip >= 4) {
+		magic = get_unaligned_le32(ip);
+		if (magic == LZ4_MAGIC) {
+			ip += 4;
+			ret = lz4_frame(&ip, iend, &op, oend);
+		} else if (magic == LZ4_LEGACY_MAGIC) {
+			ip += 4;
+			ret = lz4_legacy(&ip, iend, &op, oend);
+		} else if ((magic & LZ4_SKIP_MASK) == LZ4_SKIP_MAGIC) {
+			if (iend - ip < 8)
+				return -EINVAL;
+			ret = 0;
+			if (get_unaligned_le32(ip + 4) > iend - ip - 8)
+				return -EINVAL;
+			ip += 8 + get_unaligned_le32(ip + 4);
+		} else if (frames) {
+			/* Padding after the data, e.g. up to a block size */
+			break;
+		} else {
+			return -EINVAL;
+		}
+		if (ret)
+			return ret;
+		frames++;
+	}
+	if (!frames)
+		return -EINVAL;
+
+	*dstn = op - (u8 *)dst;
+
+	return 0;
+}
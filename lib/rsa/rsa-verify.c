@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <fdtdec.h>
+#include <hash.h>
 #include <rsa.h>
 #include <sha1.h>
 #include <asm/byteorder.h>
@@ -318,6 +319,34 @@ static int rsa_verify_with_keynode(struct image_sign_info *info,
 	return 0;
 }
 
+/*
+ * SHA-1 of all regions, through the hash table where it can hash in
+ * pieces, so that e.g. the NEON code is used
+ */
+static void rsa_hash_regions(const struct image_region region[],
+			     int region_count, uint8_t *hash)
+{
+	struct hash_algo *algo;
+	sha1_context ctx;
+	void *hctx;
+	int i;
+
+	if (!hash_lookup_algo("sha1", &algo) && algo->hash_init &&
+	    !algo->hash_init(algo, &hctx)) {
+		for (i = 0; i < region_count; i++)
+			algo->hash_update(algo, hctx, region[i].data,
+					  region[i].size,
+					  i == region_count - 1);
+		algo->hash_finish(algo, hctx, hash, SHA1_SUM_LEN);
+		return;
+	}
+
+	sha1_starts(&ctx);
+	for (i = 0; i < region_count; i++)
+		sha1_update(&ctx, region[i].data, region[i].size);
+	sha1_finish(&ctx, hash);
+}
+
 int rsa_verify(struct image_sign_info *info,
 	       const struct image_region region[], int region_count,
 	       uint8_t *sig, uint sig_len)
@@ -327,8 +356,7 @@ int rsa_verify(struct image_sign_info *info,
 	int ndepth, noffset;
 	int sig_node, node;
 	char name[100];
-	sha1_context ctx;
-	int ret, i;
+	int ret;
 
 	sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
 	if (sig_node < 0) {
@@ -336,10 +364,7 @@ int rsa_verify(struct image_sign_info *info,
 		return -ENOENT;
 	}
 
-	sha1_starts(&ctx);
-	for (i = 0; i < region_count; i++)
-		sha1_update(&ctx, region[i].data, region[i].size);
-	sha1_finish(&ctx, hash);
+	rsa_hash_regions(region, region_count, hash);
 
 	/* See if we must use a particular key */
 	if (info->required_keynode != -1) {
@@ -230,8 +230,8 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 /*
  * SHA-1 process buffer
  */
-void sha1_update(sha1_context *ctx, const unsigned char *input,
-		 unsigned int ilen)
+void sha1_update_fn(sha1_context *ctx, const unsigned char *input,
+		    unsigned int ilen, sha1_block_fn process)
 {
 	int fill;
 	unsigned long left;
@@ -250,14 +250,14 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		process(ctx, ctx->buffer);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
 	while (ilen >= 64) {
-		sha1_process (ctx, input);
+		process(ctx, input);
 		input += 64;
 		ilen -= 64;
 	}
@@ -267,6 +267,12 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 	}
 }
 
+void sha1_update(sha1_context *ctx, const unsigned char *input,
+		 unsigned int ilen)
+{
+	sha1_update_fn(ctx, input, ilen, sha1_process);
+}
+
 static const unsigned char sha1_padding[64] = {
 	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -277,7 +283,8 @@ static const unsigned char sha1_padding[64] = {
 /*
  * SHA-1 final digest
  */
-void sha1_finish (sha1_context * ctx, unsigned char output[20])
+void sha1_finish_fn(sha1_context *ctx, unsigned char output[20],
+		    sha1_block_fn process)
 {
 	unsigned long last, padn;
 	unsigned long high, low;
@@ -293,8 +300,8 @@ void sha1_finish (sha1_context * ctx, unsigned char output[20])
 	last = ctx->total[0] & 0x3F;
 	padn = (last < 56) ? (56 - last) : (120 - last);
 
-	sha1_update (ctx, (unsigned char *) sha1_padding, padn);
-	sha1_update (ctx, msglen, 8);
+	sha1_update_fn(ctx, sha1_padding, padn, process);
+	sha1_update_fn(ctx, msglen, 8, process);
 
 	PUT_UINT32_BE (ctx->state[0], output, 0);
 	PUT_UINT32_BE (ctx->state[1], output, 4);
@@ -303,6 +310,11 @@ void sha1_finish (sha1_context * ctx, unsigned char output[20])
 	PUT_UINT32_BE (ctx->state[4], output, 16);
 }
 
+void sha1_finish (sha1_context * ctx, unsigned char output[20])
+{
+	sha1_finish_fn(ctx, output, sha1_process);
+}
+
 /*
  * Output = SHA-1( input buffer )
  */
@@ -320,8 +332,9 @@ void sha1_csum(const unsigned char *input, unsigned int ilen,
  * Output = SHA-1( input buffer ). Trigger the watchdog every 'chunk_sz'
  * bytes of input processed.
  */
-void sha1_csum_wd(const unsigned char *input, unsigned int ilen,
-		  unsigned char *output, unsigned int chunk_sz)
+void sha1_csum_wd_fn(const unsigned char *input, unsigned int ilen,
+		     unsigned char *output, unsigned int chunk_sz,
+		     sha1_block_fn process)
 {
 	sha1_context ctx;
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
@@ -338,15 +351,21 @@ void sha1_csum_wd(const unsigned char *input, unsigned int ilen,
 		chunk = end - curr;
 		if (chunk > chunk_sz)
 			chunk = chunk_sz;
-		sha1_update (&ctx, curr, chunk);
+		sha1_update_fn(&ctx, curr, chunk, process);
 		curr += chunk;
 		WATCHDOG_RESET ();
 	}
 #else
-	sha1_update (&ctx, input, ilen);
+	sha1_update_fn(&ctx, input, ilen, process);
 #endif
 
-	sha1_finish (&ctx, output);
+	sha1_finish_fn(&ctx, output, process);
+}
+
+void sha1_csum_wd(const unsigned char *input, unsigned int ilen,
+		  unsigned char *output, unsigned int chunk_sz)
+{
+	sha1_csum_wd_fn(input, ilen, output, chunk_sz, sha1_process);
 }
 
 /*
@@ -179,7 +179,8 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	ctx->state[7] += H;
 }
 
-void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
+void sha256_update_fn(sha256_context *ctx, const uint8_t *input,
+		      uint32_t length, sha256_block_fn process)
 {
 	uint32_t left, fill;
 
@@ -197,14 +198,14 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		process(ctx, ctx->buffer);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
 	while (length >= 64) {
-		sha256_process(ctx, input);
+		process(ctx, input);
 		length -= 64;
 		input += 64;
 	}
@@ -213,6 +214,11 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 		memcpy((void *) (ctx->buffer + left), (void *) input, length);
 }
 
+void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
+{
+	sha256_update_fn(ctx, input, length, sha256_process);
+}
+
 static uint8_t sha256_padding[64] = {
 	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -220,7 +226,8 @@ static uint8_t sha256_padding[64] = {
 	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
-void sha256_finish(sha256_context * ctx, uint8_t digest[32])
+void sha256_finish_fn(sha256_context *ctx, uint8_t digest[32],
+		      sha256_block_fn process)
 {
 	uint32_t last, padn;
 	uint32_t high, low;
@@ -236,8 +243,8 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[32])
 	last = ctx->total[0] & 0x3F;
 	padn = (last < 56) ? (56 - last) : (120 - last);
 
-	sha256_update(ctx, sha256_padding, padn);
-	sha256_update(ctx, msglen, 8);
+	sha256_update_fn(ctx, sha256_padding, padn, process);
+	sha256_update_fn(ctx, msglen, 8, process);
 
 	PUT_UINT32_BE(ctx->state[0], digest, 0);
 	PUT_UINT32_BE(ctx->state[1], digest, 4);
@@ -249,12 +256,18 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[32])
 	PUT_UINT32_BE(ctx->state[7], digest, 28);
 }
 
+void sha256_finish(sha256_context * ctx, uint8_t digest[32])
+{
+	sha256_finish_fn(ctx, digest, sha256_process);
+}
+
 /*
  * Output = SHA-256( input buffer ). Trigger the watchdog every 'chunk_sz'
  * bytes of input processed.
  */
-void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
-		unsigned char *output, unsigned int chunk_sz)
+void sha256_csum_wd_fn(const unsigned char *input, unsigned int ilen,
+		       unsigned char *output, unsigned int chunk_sz,
+		       sha256_block_fn process)
 {
 	sha256_context ctx;
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
@@ -271,13 +284,19 @@ void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		chunk = end - curr;
 		if (chunk > chunk_sz)
 			chunk = chunk_sz;
-		sha256_update(&ctx, curr, chunk);
+		sha256_update_fn(&ctx, curr, chunk, process);
 		curr += chunk;
 		WATCHDOG_RESET();
 	}
 #else
-	sha256_update(&ctx, input, ilen);
+	sha256_update_fn(&ctx, input, ilen, process);
 #endif
 
-	sha256_finish(&ctx, output);
+	sha256_finish_fn(&ctx, output, process);
+}
+
+void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
+		unsigned char *output, unsigned int chunk_sz)
+{
+	sha256_csum_wd_fn(input, ilen, output, chunk_sz, sha256_process);
 }
@@ -9,3 +9,20 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+
+/*
+ * U-boot: on ARM and sandbox, inflate_fast() refills its bit buffer and
+ * copies matches a word at a time. Both may run a little past the current
+ * position, so it needs more input and output space on entry. The word
+ * accesses go through get_unaligned_le32() and __builtin_memcpy(), so they
+ * also build for ARMv7 with -mno-unaligned-access, where the compiler
+ * turns them into byte accesses.
+ */
+#if defined(CONFIG_ARM) || defined(CONFIG_SANDBOX)
+#  define INFLATE_CHUNK_COPY
+#  define INFLATE_FAST_MIN_IN   16
+#  define INFLATE_FAST_MIN_OUT  (258 + sizeof(unsigned long))
+#else
+#  define INFLATE_FAST_MIN_IN   6
+#  define INFLATE_FAST_MIN_OUT  258
+#endif
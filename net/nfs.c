@@ -26,6 +26,7 @@
 #include <command.h>
 #include <net.h>
 #include <malloc.h>
+#include <div64.h>
 #include "nfs.h"
 #include "bootp.h"
 
@@ -40,14 +41,39 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+/* RPC header, status, attributes and data length of a READ reply */
+#define NFS_READ_HDR_SIZE	(32 * 4)
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
+static int nfs_version;		/* NFS_V3, or NFS_V2 for older servers */
+
+static char dirfh[NFS3_FHSIZE];	/* file handle of directory */
+static unsigned int dirfh_len;
+static char filefh[NFS3_FHSIZE]; /* file handle of kernel image */
+static unsigned int filefh_len;
+static int nfs_ftype;		/* from the lookup, 0 if not known */
 
-static char dirfh[NFS_FHSIZE];	/* file handle of directory */
-static char filefh[NFS_FHSIZE]; /* file handle of kernel image */
+/*
+ * Up to nfs_window READ requests are outstanding at a time, each for its
+ * own part of the file. Replies may come back in any order; each is
+ * stored at its offset and its slot is reused for the next part.
+ */
+struct nfs_read_slot {
+	unsigned long id;	/* RPC id of the request */
+	ulong offset;
+	unsigned int len;	/* 0 if the slot is free */
+};
+
+static struct nfs_read_slot nfs_reads[NFS_MAX_WINDOWSIZE];
+static int nfs_window;
+static unsigned int nfs_read_size;
+static ulong nfs_next;		/* next offset to ask for */
+static ulong nfs_eof;		/* file size, ~0 while not known */
+static ulong nfs_hash_bytes;	/* received since the last hash mark */
+static int nfs_hashes;
+static ulong nfs_time_start;
 
 static enum net_loop_state nfs_download_state;
 static IPaddr_t NfsServerIP;
@@ -174,7 +200,7 @@ static long *rpc_add_credentials(long *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void
+static unsigned long
 rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 {
 	struct rpc_t pkt;
@@ -188,7 +214,10 @@ rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 	pkt.u.call.type = htonl(MSG_CALL);
 	pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
 	pkt.u.call.prog = htonl(rpc_prog);
-	pkt.u.call.vers = htonl(2);	/* portmapper is version 2 */
+	if (rpc_prog == PROG_PORTMAP)
+		pkt.u.call.vers = htonl(2);	/* portmapper is version 2 */
+	else	/* MOUNT v3 goes with NFSv3, MOUNT v2 with NFSv2 */
+		pkt.u.call.vers = htonl(nfs_version);
 	pkt.u.call.proc = htonl(rpc_proc);
 	p = (uint32_t *)&(pkt.u.call.data);
 
@@ -209,6 +238,21 @@ rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 
 	NetSendUDPPacket(NetServerEther, NfsServerIP, sport, NfsOurPort,
 		pktlen);
+
+	return id;
+}
+
+/* Add a file handle: fixed size in NFSv2, counted in NFSv3 */
+static uint32_t *
+nfs_add_fh(uint32_t *p, const char *fh, unsigned int fhlen)
+{
+	if (nfs_version == NFS_V3)
+		*p++ = htonl(fhlen);
+	if (fhlen & 3)
+		*(p + fhlen / 4) = 0;
+	memcpy(p, fh, fhlen);
+
+	return p + (fhlen + 3) / 4;
 }
 
 /**************************************************************************
@@ -280,8 +324,9 @@ nfs_umountall_req(void)
 
 /***************************************************************************
  * NFS_READLINK (AH 2003-07-14)
- * This procedure is called when read of the first block fails -
- * this probably happens when it's a directory or a symlink
+ * This procedure is called when the lookup finds a symlink, or when read
+ * of the first block fails - this probably happens when it's a directory
+ * or a symlink
  * In case of successful readlink(), the dirname is manipulated,
  * so that inside the nfs() function a recursion can be done.
  **************************************************************************/
@@ -295,12 +340,12 @@ nfs_readlink_req(void)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, filefh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, filefh, filefh_len);
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READLINK, data, len);
+	rpc_req(PROG_NFS, nfs_version == NFS_V3 ? NFS3_READLINK : NFS_READLINK,
+		data, len);
 }
 
 /**************************************************************************
@@ -319,8 +364,7 @@ nfs_lookup_req(char *fname)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, dirfh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, dirfh, dirfh_len);
 	*p++ = htonl(fnamelen);
 	if (fnamelen & 3)
 		*(p + fnamelen / 4) = 0;
@@ -329,14 +373,15 @@ nfs_lookup_req(char *fname)
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_LOOKUP, data, len);
+	rpc_req(PROG_NFS, nfs_version == NFS_V3 ? NFS3_LOOKUP : NFS_LOOKUP,
+		data, len);
 }
 
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
 static void
-nfs_read_req(int offset, int readlen)
+nfs_read_req(struct nfs_read_slot *r)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -345,15 +390,78 @@ nfs_read_req(int offset, int readlen)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, filefh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
-	*p++ = htonl(offset);
-	*p++ = htonl(readlen);
-	*p++ = 0;
+	p = nfs_add_fh(p, filefh, filefh_len);
+	if (nfs_version == NFS_V3) {
+		*p++ = 0;		/* high word of the 64 bit offset */
+		*p++ = htonl(r->offset);
+		*p++ = htonl(r->len);
+	} else {
+		*p++ = htonl(r->offset);
+		*p++ = htonl(r->len);
+		*p++ = 0;		/* totalcount, unused */
+	}
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	r->id = rpc_req(PROG_NFS, nfs_version == NFS_V3 ? NFS3_READ : NFS_READ,
+			data, len);
+}
+
+/* Ask for the next parts of the file until the window is full */
+static void
+nfs_read_fill(void)
+{
+	struct nfs_read_slot *r;
+
+	for (r = nfs_reads; r < nfs_reads + nfs_window; r++) {
+		if (r->len || nfs_next >= nfs_eof)
+			continue;
+		r->offset = nfs_next;
+		r->len = min((ulong)nfs_read_size, nfs_eof - nfs_next);
+		nfs_next += r->len;
+		nfs_read_req(r);
+	}
+}
+
+/* Send the outstanding requests again, then fill the window */
+static void
+nfs_read_resend(void)
+{
+	struct nfs_read_slot *r;
+
+	for (r = nfs_reads; r < nfs_reads + nfs_window; r++) {
+		if (r->len)
+			nfs_read_req(r);
+	}
+	nfs_read_fill();
+}
+
+static int
+nfs_read_busy(void)
+{
+	int i;
+
+	for (i = 0; i < nfs_window; i++) {
+		if (nfs_reads[i].len)
+			return 1;
+	}
+
+	return 0;
+}
+
+/* Start reading the file; nfs_eof is its size from the lookup */
+static void
+nfs_read_start(void)
+{
+	memset(nfs_reads, 0, sizeof(nfs_reads));
+	nfs_next = 0;
+	nfs_hash_bytes = 0;
+	nfs_hashes = 0;
+	if (nfs_version == NFS_V3)
+		nfs_read_size = NFS_READ_SIZE;
+	else
+		nfs_read_size = min(NFS_READ_SIZE, NFS_MAXDATA);
+	nfs_time_start = get_timer(0);
 }
 
 /**************************************************************************
@@ -367,10 +475,10 @@ NfsSend(void)
 
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
-		rpc_lookup_req(PROG_MOUNT, 1);
+		rpc_lookup_req(PROG_MOUNT, nfs_version == NFS_V3 ? 3 : 1);
 		break;
 	case STATE_PRCLOOKUP_PROG_NFS_REQ:
-		rpc_lookup_req(PROG_NFS, 2);
+		rpc_lookup_req(PROG_NFS, nfs_version);
 		break;
 	case STATE_MOUNT_REQ:
 		nfs_mount_req(nfs_path);
@@ -382,7 +490,7 @@ NfsSend(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -445,8 +553,16 @@ nfs_mount_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
+	if (nfs_version == NFS_V3) {
+		dirfh_len = ntohl(rpc_pkt.u.reply.data[1]);
+		if (dirfh_len > NFS3_FHSIZE)
+			return -1;
+		memcpy(dirfh, rpc_pkt.u.reply.data + 2, dirfh_len);
+	} else {
+		dirfh_len = NFS_FHSIZE;
+		memcpy(dirfh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	}
 	fs_mounted = 1;
-	memcpy(dirfh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
 
 	return 0;
 }
@@ -480,6 +596,8 @@ static int
 nfs_lookup_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	uint32_t *data;
+	int nwords;
 
 	debug("%s\n", __func__);
 
@@ -496,7 +614,32 @@ nfs_lookup_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
-	memcpy(filefh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	data = rpc_pkt.u.reply.data + 1;
+	if (nfs_version == NFS_V3) {
+		filefh_len = ntohl(*data++);
+		if (filefh_len > NFS3_FHSIZE)
+			return -1;
+		memcpy(filefh, data, filefh_len);
+		data += (filefh_len + 3) / 4;
+		/* post_op_attr: a flag, then the attributes if it is set */
+		nwords = ntohl(*data++) ? NFS3_FATTR_WORDS : 0;
+	} else {
+		filefh_len = NFS_FHSIZE;
+		memcpy(filefh, data, NFS_FHSIZE);
+		data += NFS_FHSIZE / 4;
+		nwords = NFS_FATTR_WORDS;
+	}
+
+	/* Type and size let the reads stop at the end of the file */
+	nfs_ftype = 0;
+	nfs_eof = ~0UL;
+	if (!nwords || (uchar *)(data + nwords) - (uchar *)&rpc_pkt > len)
+		return 0;
+	nfs_ftype = ntohl(data[0]);
+	if (nfs_version == NFS_V3 && !data[5])
+		nfs_eof = ntohl(data[6]);	/* 64 bit size */
+	else if (nfs_version == NFS_V2)
+		nfs_eof = ntohl(data[5]);
 
 	return 0;
 }
@@ -505,7 +648,9 @@ static int
 nfs_readlink_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	uint32_t *data;
+	char *path;
+	unsigned rlen;
 
 	debug("%s\n", __func__);
 
@@ -522,36 +667,63 @@ nfs_readlink_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
-	rlen = ntohl(rpc_pkt.u.reply.data[1]); /* new path length */
+	data = rpc_pkt.u.reply.data + 1;
+	if (nfs_version == NFS_V3 && ntohl(*data++))
+		data += NFS3_FATTR_WORDS;	/* symlink attributes */
+	rlen = ntohl(*data++); /* new path length */
+	path = (char *)data;
+	if (path - (char *)&rpc_pkt > len ||
+	    rlen > len - (path - (char *)&rpc_pkt) ||
+	    strlen(nfs_path) + 1 + rlen >= sizeof(nfs_path_buff))
+		return -1;
 
-	if (*((char *)&(rpc_pkt.u.reply.data[2])) != '/') {
+	if (*path != '/') {
 		int pathlen;
 		strcat(nfs_path, "/");
 		pathlen = strlen(nfs_path);
-		memcpy(nfs_path + pathlen, (uchar *)&(rpc_pkt.u.reply.data[2]),
-			rlen);
+		memcpy(nfs_path + pathlen, path, rlen);
 		nfs_path[pathlen + rlen] = 0;
 	} else {
-		memcpy(nfs_path, (uchar *)&(rpc_pkt.u.reply.data[2]), rlen);
+		memcpy(nfs_path, path, rlen);
 		nfs_path[rlen] = 0;
 	}
 	return 0;
 }
 
+static void
+nfs_progress(unsigned len)
+{
+	nfs_hash_bytes += len;
+	while (nfs_hash_bytes >= nfs_read_size / 2 * 10) {
+		nfs_hash_bytes -= nfs_read_size / 2 * 10;
+		if (nfs_hashes && !(nfs_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		nfs_hashes++;
+	}
+}
+
 static int
 nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *r;
+	uint32_t *data;
+	unsigned hlen, rlen;
+	unsigned long id;
+	int eof = 0;
 
 	debug("%s\n", __func__);
 
-	memcpy((uchar *)&rpc_pkt, pkt, sizeof(rpc_pkt.u.reply));
+	memcpy((uchar *)&rpc_pkt, pkt, min(len, (unsigned)NFS_READ_HDR_SIZE));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
-		return -NFS_RPC_DROP;
+	id = ntohl(rpc_pkt.u.reply.id);
+	for (r = nfs_reads; r < nfs_reads + nfs_window; r++) {
+		if (r->len && r->id == id)
+			break;
+	}
+	if (r == nfs_reads + nfs_window)
+		return -NFS_RPC_DROP;	/* late reply to a resent request */
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -564,20 +736,53 @@ nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
+	data = rpc_pkt.u.reply.data + 1;
+	if (nfs_version == NFS_V3) {
+		if (ntohl(*data++))		/* post_op_attr */
+			data += NFS3_FATTR_WORDS;
+		data++;				/* count */
+		eof = ntohl(*data++);
+	} else {
+		data += NFS_FATTR_WORDS;
+	}
+	rlen = ntohl(*data++);
+	hlen = (uchar *)data - (uchar *)&rpc_pkt;
+	if (hlen > len || rlen > len - hlen || rlen > r->len)
+		return -NFS_RPC_DROP;	/* garbled, wait for the resend */
 
-	rlen = ntohl(rpc_pkt.u.reply.data[18]);
-	if (store_block((uchar *)pkt + sizeof(rpc_pkt.u.reply),
-			nfs_offset, rlen))
+	if (rlen && store_block(pkt + hlen, r->offset, rlen))
 		return -9999;
+	nfs_progress(rlen);
+
+	if (eof || !rlen)
+		nfs_eof = min(nfs_eof, r->offset + rlen);
+	if (rlen < r->len && r->offset + rlen < nfs_eof) {
+		/* A short read: ask for the rest of this part */
+		r->offset += rlen;
+		r->len -= rlen;
+		nfs_read_req(r);
+	} else {
+		r->len = 0;
+	}
 
 	return rlen;
 }
 
+static void
+nfs_read_done(void)
+{
+	ulong time = get_timer(nfs_time_start);
+
+	if (time > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(lldiv((u64)NetBootFileXferSize * 1000, time),
+			   "/s");
+	}
+	printf("\n\t %lu bytes in %lu ms, NFSv%d, rsize %u, windowsize %d",
+	       NetBootFileXferSize, time, nfs_version, nfs_read_size,
+	       nfs_window);
+}
+
 /**************************************************************************
 Interfaces of U-BOOT
 **************************************************************************/
@@ -609,16 +814,27 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
-		if (rpc_lookup_reply(PROG_MOUNT, pkt, len) == -NFS_RPC_DROP)
+		reply = rpc_lookup_reply(PROG_MOUNT, pkt, len);
+		if (reply == -NFS_RPC_DROP)
 			break;
-		NfsState = STATE_PRCLOOKUP_PROG_NFS_REQ;
+		if (!reply && !NfsSrvMountPort && nfs_version == NFS_V3)
+			nfs_version = NFS_V2;	/* ask for version 1 */
+		else
+			NfsState = STATE_PRCLOOKUP_PROG_NFS_REQ;
 		NfsSend();
 		break;
 
 	case STATE_PRCLOOKUP_PROG_NFS_REQ:
-		if (rpc_lookup_reply(PROG_NFS, pkt, len) == -NFS_RPC_DROP)
+		reply = rpc_lookup_reply(PROG_NFS, pkt, len);
+		if (reply == -NFS_RPC_DROP)
 			break;
-		NfsState = STATE_MOUNT_REQ;
+		if (!reply && !NfsSrvNfsPort && nfs_version == NFS_V3) {
+			/* No NFSv3 on the server: fall back to version 2 */
+			nfs_version = NFS_V2;
+			NfsState = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+		} else {
+			NfsState = STATE_MOUNT_REQ;
+		}
 		NfsSend();
 		break;
 
@@ -658,11 +874,19 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 			puts("*** ERROR: File lookup fail\n");
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
+		} else if (nfs_ftype == NFLNK) {
+			NfsState = STATE_READLINK_REQ;
+			NfsSend();
 		} else {
 			NfsState = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			nfs_read_start();
 			NfsSend();
+			if (!nfs_read_busy()) {
+				/* an empty file */
+				nfs_download_state = NETLOOP_SUCCESS;
+				NfsState = STATE_UMOUNT_REQ;
+				NfsSend();
+			}
 		}
 		break;
 
@@ -686,17 +910,22 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 
 	case STATE_READ_REQ:
 		rlen = nfs_read_reply(pkt, len);
+		if (rlen == -NFS_RPC_DROP)
+			break;
 		NetSetTimeout(nfs_timeout, NfsTimeout);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			nfs_read_fill();
+			if (nfs_read_busy())
+				break;
+			nfs_read_done();
+			nfs_download_state = NETLOOP_SUCCESS;
+			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			NfsState = STATE_READLINK_REQ;
 			NfsSend();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
 		}
@@ -708,6 +937,8 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 void
 NfsStart(void)
 {
+	char *ep;
+
 	debug("%s\n", __func__);
 	nfs_download_state = NETLOOP_FAIL;
 
@@ -775,6 +1006,13 @@ NfsStart(void)
 
 	NfsTimeoutCount = 0;
 	NfsState = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+	nfs_version = NFS_V3;
+
+	nfs_window = NFS_WINDOWSIZE;
+	ep = getenv("nfswindowsize");
+	if (ep != NULL)
+		nfs_window = simple_strtol(ep, NULL, 10);
+	nfs_window = max(1, min(nfs_window, NFS_MAX_WINDOWSIZE));
 
 	/*NfsOurPort = 4096 + (get_ticks() % 3072);*/
 	/*FIX ME !!!*/
@@ -21,11 +21,26 @@
 #define MOUNT_ADDENTRY  1
 #define MOUNT_UMOUNTALL 4
 
+#define NFS_V2          2
+#define NFS_V3          3
+
 #define NFS_LOOKUP      4
 #define NFS_READLINK    5
 #define NFS_READ        6
 
+#define NFS3_LOOKUP     3
+#define NFS3_READLINK   5
+#define NFS3_READ       6
+
 #define NFS_FHSIZE      32
+#define NFS3_FHSIZE     64
+
+/* Attributes in replies: fattr (v2) and fattr3 sizes in 32 bit words */
+#define NFS_FATTR_WORDS         17
+#define NFS3_FATTR_WORDS        21
+
+#define NFREG           1
+#define NFLNK           5
 
 #define NFSERR_PERM     1
 #define NFSERR_NOENT    2
@@ -44,6 +59,16 @@
 #define NFS_READ_SIZE 1024 /* biggest power of two that fits Ether frame */
 #endif
 
+#define NFS_MAXDATA 8192 /* largest NFSv2 read; NFSv3 has no such limit */
+
+/* Number of READ requests kept in flight at once */
+#ifdef CONFIG_NFS_WINDOWSIZE
+#define NFS_WINDOWSIZE CONFIG_NFS_WINDOWSIZE
+#else
+#define NFS_WINDOWSIZE 1
+#endif
+#define NFS_MAX_WINDOWSIZE 16
+
 #define NFS_MAXLINKDEPTH 16
 
 struct rpc_t {
@@ -8,7 +8,9 @@
 
 #include <common.h>
 #include <command.h>
+#include <hash.h>
 #include <net.h>
+#include <div64.h>
 #include "tftp.h"
 #include "bootp.h"
 #ifdef CONFIG_SYS_DIRECT_FLASH_TFTP
@@ -127,9 +129,29 @@ static char tftp_filename[MAX_LEN];
 #define TFTP_MTU_BLOCKSIZE 1468
 #endif
 
+/* Largest block that fits an Ethernet frame without IP fragmentation */
+#define TFTP_ETH_BLOCKSIZE	(1500 - (int)IP_UDP_HDR_SIZE - 4)
+
 static unsigned short TftpBlkSize = TFTP_BLOCK_SIZE;
 static unsigned short TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 lets the server send a window of blocks per ACK instead of one.
+ * A window of 1 is plain lock-step TFTP, the option is not even sent then.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short TftpWindowSize = 1;
+static unsigned short TftpWindowSizeOption = TFTP_WINDOWSIZE;
+/* block number that completes the current window */
+static unsigned short TftpNextAck;
+/* 1 once the block preceding a gap in the window has been ACKed again */
+static int TftpGapAcked;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -185,6 +207,8 @@ store_block(int block, uchar *src, unsigned len)
 #endif /* CONFIG_SYS_DIRECT_FLASH_TFTP */
 	{
 		(void)memcpy((void *)(load_addr + offset), src, len);
+		hash_load_update(offset, src, len);
+		image_stream_update(offset, src, len);
 	}
 #ifdef CONFIG_MCAST_TFTP
 	if (Multicast)
@@ -201,6 +225,8 @@ static void new_transfer(void)
 	TftpLastBlock = 0;
 	TftpBlockWrap = 0;
 	TftpBlockWrapOffset = 0;
+	TftpNextAck = TftpWindowSize;
+	TftpGapAcked = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 	TftpFinalBlock = 0;
 #endif
@@ -290,6 +316,34 @@ static void update_block_number(void)
 	}
 }
 
+/*
+ * Check that a data block follows the last one received. Within a window a
+ * lost block shows up as a gap: everything up to the missing block is then
+ * dropped and the last block received in sequence is ACKed once, which has
+ * the server resend the window from there.
+ * Return 1 if the block is to be handled, 0 if it was dropped.
+ */
+static int tftp_window_check(void)
+{
+	if (TftpWindowSize <= 1 || TftpState != STATE_DATA)
+		return 1;
+	if (TftpBlock == TftpLastBlock ||
+	    TftpBlock == (unsigned short)(TftpLastBlock + 1))
+		return 1;
+
+	debug("TFTP window gap: got %ld, expected %ld\n", TftpBlock,
+	      (TftpLastBlock + 1) & 0xffff);
+	/* a timeout from here on has to ACK the last block in sequence too */
+	TftpBlock = TftpLastBlock;
+	if (!TftpGapAcked) {
+		TftpSend();
+		TftpNextAck = TftpLastBlock + TftpWindowSize;
+		TftpGapAcked = 1;
+	}
+
+	return 0;
+}
+
 /* The TFTP get or put is complete */
 static void tftp_complete(void)
 {
@@ -303,10 +357,16 @@ static void tftp_complete(void)
 	time_start = get_timer(time_start);
 	if (time_start > 0) {
 		puts("\n\t ");	/* Line up with "Loading: " */
-		print_size(NetBootFileXferSize /
-			time_start * 1000, "/s");
+		print_size(lldiv((u64)NetBootFileXferSize * 1000,
+				 time_start), "/s");
 	}
+	printf("\n\t %lu bytes in %lu ms, blksize %d, windowsize %d",
+	       NetBootFileXferSize, time_start, TftpBlkSize, TftpWindowSize);
 	puts("\ndone\n");
+	if (!TftpWriting) {
+		hash_load_finish(load_addr, NetBootFileXferSize);
+		image_stream_finish(NetBootFileXferSize);
+	}
 	net_set_state(NETLOOP_SUCCESS);
 }
 
@@ -359,6 +419,10 @@ TftpSend(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, TftpBlkSizeOption, 0);
+		/* and for a window of blocks per ACK, unless lock-step */
+		if (TftpState == STATE_SEND_RRQ && TftpWindowSizeOption > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSizeOption, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!ProhibitMcast) {
@@ -528,6 +592,13 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				debug("Blocksize ack: %s, %d\n",
 					(char *)pkt+i+8, TftpBlkSize);
 			}
+			if (strcmp((char *)pkt+i, "windowsize") == 0) {
+				TftpWindowSize = (unsigned short)
+					simple_strtoul((char *)pkt+i+11, NULL,
+						       10);
+				debug("Windowsize ack: %s, %d\n",
+					(char *)pkt+i+11, TftpWindowSize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				TftpTsize = simple_strtoul((char *)pkt+i+6,
@@ -537,8 +608,12 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			}
 #endif
 		}
+		if (TftpWindowSize < 1)
+			TftpWindowSize = 1;
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len-1);
+		if (Multicast)
+			TftpWindowSize = 1;
 		if ((Multicast) && (!MasterClient))
 			TftpState = STATE_DATA;	/* passive.. */
 		else
@@ -558,6 +633,10 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		len -= 2;
 		TftpBlock = ntohs(*(__be16 *)pkt);
 
+		/* before the wrap check, which a gap in the window upsets */
+		if (!tftp_window_check())
+			break;
+
 		update_block_number();
 
 		if (TftpState == STATE_SEND_RRQ)
@@ -593,6 +672,7 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		}
 
 		TftpLastBlock = TftpBlock;
+		TftpGapAcked = 0;
 		TftpTimeoutCountMax = TIMEOUT_COUNT;
 		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
 
@@ -600,7 +680,8 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 
 		/*
 		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	the remote for the next one. With a window only its
+		 *	last block and the final, short one are acknowledged.
 		 */
 #ifdef CONFIG_MCAST_TFTP
 		/* if I am the MasterClient, actively calculate what my next
@@ -627,7 +708,11 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			}
 		}
 #endif
-		TftpSend();
+		if (TftpWindowSize <= 1 || TftpBlock == TftpNextAck ||
+		    len < TftpBlkSize) {
+			TftpSend();
+			TftpNextAck = TftpBlock + TftpWindowSize;
+		}
 
 #ifdef CONFIG_MCAST_TFTP
 		if (Multicast) {
@@ -697,6 +782,19 @@ void TftpStart(enum proto_t protocol)
 	if (ep != NULL)
 		TftpBlkSizeOption = simple_strtol(ep, NULL, 10);
 
+#ifndef CONFIG_IP_DEFRAG
+	/* bigger blocks would arrive fragmented and be dropped */
+	if (TftpBlkSizeOption > TFTP_ETH_BLOCKSIZE) {
+		printf("TFTP blocksize %d needs CONFIG_IP_DEFRAG, using %d\n",
+		       TftpBlkSizeOption, TFTP_ETH_BLOCKSIZE);
+		TftpBlkSizeOption = TFTP_ETH_BLOCKSIZE;
+	}
+#endif
+
+	ep = getenv("tftpwindowsize");
+	if (ep != NULL)
+		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
+
 	ep = getenv("tftptimeout");
 	if (ep != NULL)
 		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
@@ -708,8 +806,8 @@ void TftpStart(enum proto_t protocol)
 		TftpTimeoutMSecs = 1000;
 	}
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-		TftpBlkSizeOption, TftpTimeoutMSecs);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+		TftpBlkSizeOption, TftpWindowSizeOption, TftpTimeoutMSecs);
 
 	TftpRemoteIP = NetServerIP;
 	if (BootFile[0] == '\0') {
@@ -780,6 +878,8 @@ void TftpStart(enum proto_t protocol)
 		printf("Load address: 0x%lx\n", load_addr);
 		puts("Loading: *\b");
 		TftpState = STATE_SEND_RRQ;
+		hash_load_start();
+		image_stream_start(load_addr);
 	}
 
 	time_start = get_timer(0);
@@ -807,8 +907,9 @@ void TftpStart(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(NetServerEther, 0, 6);
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -831,14 +932,17 @@ TftpStartServer(void)
 	printf("Load address: 0x%lx\n", load_addr);
 
 	puts("Loading: *\b");
+	hash_load_start();
+	image_stream_start(load_addr);
 
 	TftpTimeoutCountMax = TIMEOUT_COUNT;
 	TftpTimeoutCount = 0;
 	TftpTimeoutMSecs = TIMEOUT;
 	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
 
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
 	TftpBlock = 0;
 	TftpOurPort = WELL_KNOWN_PORT;
 
@@ -9,6 +9,11 @@
 #include <common.h>
 #include <command.h>
 #include <malloc.h>
+#include <div64.h>
+#include <image.h>
+#include <asm/io.h>
+#include <u-boot/crc.h>
+#include <test/errcheck.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -18,6 +23,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <lz4.h>
 
 static const char plain[] =
 	"I am a highly compressable bit of text.\n"
@@ -92,6 +98,28 @@ static const char lzo_compressed[] =
 	"\x73\x61\x67\x65\x73\x2e\x0a\x11\x00\x00\x00\x00\x00\x00";
 static const unsigned long lzo_compressed_size = 334;
 
+/* lz4 -z /tmp/plain.txt > /tmp/plain.lz4 */
+static const char lz4_compressed[] =
+	"\x04\x22\x4d\x18\x64\x40\xa7\x01\x01\x00\x00\xff\x19\x49\x20\x61"
+	"\x6d\x20\x61\x20\x68\x69\x67\x68\x6c\x79\x20\x63\x6f\x6d\x70\x72"
+	"\x65\x73\x73\x61\x62\x6c\x65\x20\x62\x69\x74\x20\x6f\x66\x20\x74"
+	"\x65\x78\x74\x2e\x0a\x28\x00\x3d\xf1\x25\x54\x68\x65\x72\x65\x20"
+	"\x61\x72\x65\x20\x6d\x61\x6e\x79\x20\x6c\x69\x6b\x65\x20\x6d\x65"
+	"\x2c\x20\x62\x75\x74\x20\x74\x68\x69\x73\x20\x6f\x6e\x65\x20\x69"
+	"\x73\x20\x6d\x69\x6e\x65\x2e\x0a\x49\x66\x20\x49\x20\x77\x32\x00"
+	"\xd1\x6e\x79\x20\x73\x68\x6f\x72\x74\x65\x72\x2c\x20\x74\x45\x00"
+	"\xf4\x0b\x77\x6f\x75\x6c\x64\x6e\x27\x74\x20\x62\x65\x20\x6d\x75"
+	"\x63\x68\x20\x73\x65\x6e\x73\x65\x20\x69\x6e\x0a\xcf\x00\x50\x69"
+	"\x6e\x67\x20\x6d\x12\x00\x00\x32\x00\xf0\x11\x20\x66\x69\x72\x73"
+	"\x74\x20\x70\x6c\x61\x63\x65\x2e\x20\x41\x74\x20\x6c\x65\x61\x73"
+	"\x74\x20\x77\x69\x74\x68\x20\x6c\x7a\x6f\x2c\x63\x00\xf5\x14\x77"
+	"\x61\x79\x2c\x0a\x77\x68\x69\x63\x68\x20\x61\x70\x70\x65\x61\x72"
+	"\x73\x20\x74\x6f\x20\x62\x65\x68\x61\x76\x65\x20\x70\x6f\x6f\x72"
+	"\x6c\x79\x4e\x00\x30\x61\x63\x65\x27\x01\x01\x95\x00\x01\x2d\x01"
+	"\xb0\x0a\x6d\x65\x73\x73\x61\x67\x65\x73\x2e\x0a\x00\x00\x00\x00"
+	"\x9d\x12\x8c\x9d";
+static const unsigned long lz4_compressed_size = 276;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -224,10 +252,37 @@ static int uncompress_using_lzo(void *in, unsigned long in_size,
 	return (ret != LZO_E_OK);
 }
 
-#define errcheck(statement) if (!(statement)) { \
-	fprintf(stderr, "\tFailed: %s\n", #statement); \
-	ret = 1; \
-	goto out; \
+static int compress_using_lz4(void *in, unsigned long in_size,
+			      void *out, unsigned long out_max,
+			      unsigned long *out_size)
+{
+	/* There is no lz4 compression in u-boot, so fake it. */
+	assert(in_size == strlen(plain));
+	assert(memcmp(plain, in, in_size) == 0);
+
+	if (lz4_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, lz4_compressed, lz4_compressed_size);
+	if (out_size)
+		*out_size = lz4_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_lz4(void *in, unsigned long in_size,
+				void *out, unsigned long out_max,
+				unsigned long *out_size)
+{
+	int ret;
+	size_t input_size = in_size;
+	size_t output_size = out_max;
+
+	ret = ulz4fn(in, input_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
 }
 
 static int run_test(char *name, mutate_func compress, mutate_func uncompress)
@@ -314,22 +369,215 @@ out:
 }
 
 
+#ifdef CONFIG_IMAGE_STREAM
+/*
+ * Hand a gzip kernel uImage to image_stream_*() in 3 byte pieces, so that
+ * the gzip header arrives in parts. Like a loader, store it at an address
+ * other than 0, with the bytes still to come holding garbage.
+ */
+#define STREAM_ADDR	0x100000
+#define STREAM_LOAD	0x200000
+
+static int run_stream_test(void)
+{
+	ulong hlen = sizeof(image_header_t);
+	ulong orig_size = strlen(plain);
+	ulong compressed_size, file_size, offset, len;
+	image_header_t *hdr;
+	uchar *src = NULL;
+	uchar *file;
+	int ret;
+
+	printf(" testing image stream ...\n");
+
+	src = malloc(hlen + TEST_BUFFER_SIZE);
+	errcheck(src != NULL);
+	compressed_size = TEST_BUFFER_SIZE;
+	errcheck(compress_using_gzip((void *)plain, orig_size, src + hlen,
+				     compressed_size, &compressed_size) == 0);
+
+	hdr = (image_header_t *)src;
+	memset(hdr, 0, hlen);
+	image_set_magic(hdr, IH_MAGIC);
+	image_set_size(hdr, compressed_size);
+	image_set_load(hdr, STREAM_LOAD);
+	image_set_ep(hdr, STREAM_LOAD);
+	image_set_dcrc(hdr, crc32(0, src + hlen, compressed_size));
+	image_set_os(hdr, IH_OS_LINUX);
+	image_set_arch(hdr, IH_ARCH_SANDBOX);
+	image_set_type(hdr, IH_TYPE_KERNEL);
+	image_set_comp(hdr, IH_COMP_GZIP);
+	image_set_hcrc(hdr, crc32(0, src, hlen));
+
+	file_size = hlen + compressed_size;
+	file = map_sysmem(STREAM_ADDR, file_size);
+	memset(file, 0xff, file_size);
+	memset(map_sysmem(STREAM_LOAD, orig_size), 0, orig_size);
+
+	setenv("loadunzip", "yes");
+	image_stream_start(STREAM_ADDR);
+	for (offset = 0; offset < file_size; offset += len) {
+		len = min(3UL, file_size - offset);
+		memcpy(file + offset, src + offset, len);
+		image_stream_update(offset, file + offset, len);
+	}
+	image_stream_finish(file_size);
+
+	errcheck(image_stream_take((image_header_t *)file, &len) == 1);
+	printf("\tuncompressed_size:%lu\n", len);
+	errcheck(len == orig_size);
+	errcheck(memcmp(map_sysmem(STREAM_LOAD, len), plain, len) == 0);
+
+	ret = 0;
+out:
+	setenv("loadunzip", NULL);
+	printf(" image stream: %s\n", ret == 0 ? "ok" : "FAILED");
+	free(src);
+
+	return ret;
+}
+#endif
+
+
+static const struct {
+	char *name;
+	mutate_func compress;
+	mutate_func uncompress;
+} codecs[] = {
+	{ "gzip", compress_using_gzip, uncompress_using_gzip },
+	{ "bzip2", compress_using_bzip2, uncompress_using_bzip2 },
+	{ "lzma", compress_using_lzma, uncompress_using_lzma },
+	{ "lzo", compress_using_lzo, uncompress_using_lzo },
+	{ "lz4", compress_using_lz4, uncompress_using_lz4 },
+};
+
 static int do_test_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
 {
 	int err = 0;
+	int i;
 
-	err += run_test("gzip", compress_using_gzip, uncompress_using_gzip);
-	err += run_test("bzip2", compress_using_bzip2, uncompress_using_bzip2);
-	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
-	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
+	for (i = 0; i < ARRAY_SIZE(codecs); i++)
+		err += run_test(codecs[i].name, codecs[i].compress,
+				codecs[i].uncompress);
+#ifdef CONFIG_IMAGE_STREAM
+	err += run_stream_test();
+#endif
 
-	printf("test_compression %s\n", err == 0 ? "ok" : "FAILED");
+	return test_report("test_compression", err);
+}
+
+U_BOOT_CMD(
+	test_compression,	5,	1,	do_test_compression,
+	"Basic test of compressors: gzip bzip2 lzma lzo lz4", ""
+);
+
+/* Time each decompressor for at least this long */
+#define BENCH_MS	200
+#define BENCH_TEXT_SIZE	(4 << 20)
+
+static int bench(char *name, mutate_func compress, mutate_func uncompress,
+		 void *orig_buf, ulong orig_size)
+{
+	ulong compressed_size, out_size, start, ms;
+	void *compressed_buf, *out_buf;
+	u64 bytes = 0;
+	int ret = 1;
+
+	compressed_size = orig_size + orig_size / 8 + 1024;
+	compressed_buf = malloc(compressed_size);
+	out_buf = malloc(orig_size);
+	if (!compressed_buf || !out_buf)
+		goto out;
+	if (compress(orig_buf, orig_size, compressed_buf, compressed_size,
+		     &compressed_size))
+		goto out;
+
+	start = get_timer(0);
+	do {
+		if (uncompress(compressed_buf, compressed_size, out_buf,
+			       orig_size, &out_size) || out_size != orig_size)
+			goto out;
+		bytes += orig_size;
+		ms = get_timer(start);
+	} while (ms < BENCH_MS);
+	if (memcmp(orig_buf, out_buf, orig_size))
+		goto out;
+	ret = 0;
+
+	printf("%-6s %8lu -> %8lu bytes, %10llu bytes in %4lu ms, ", name,
+	       compressed_size, orig_size, bytes, ms);
+	print_size(lldiv(bytes * 1000, ms), "/s\n");
+out:
+	if (ret)
+		printf("%-6s FAILED\n", name);
+	free(out_buf);
+	free(compressed_buf);
+
+	return ret;
+}
+
+/*
+ * Fill @buf with @size bytes of pseudo-random runs of the built-in text,
+ * each followed by a short literal, so that it inflates with the mix of
+ * matches and literals of real text rather than from one small window
+ */
+static void bench_text(char *buf, ulong size)
+{
+	ulong plain_len = strlen(plain);
+	ulong done, pos, len;
+	u32 seed = 1;
+
+	for (done = 0; done < size; done += len) {
+		seed = seed * 1103515245 + 12345;
+		pos = (seed >> 8) % plain_len;
+		len = min(4 + (ulong)(seed >> 24) % 60, plain_len - pos);
+		len = min(len, size - done);
+		memcpy(buf + done, plain + pos, len);
+		if (done + len < size)
+			buf[done + len++] = 'a' + (seed >> 3) % 26;
+	}
+}
+
+static int do_test_compression_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+				     char * const argv[])
+{
+	int err = 0;
+	char *text;
+	int i;
+
+	/* Only gzip can compress other data than the built-in text */
+	if (argc == 3)
+		return bench("gzip", compress_using_gzip,
+			     uncompress_using_gzip,
+			     map_sysmem(simple_strtoul(argv[1], NULL, 16), 0),
+			     simple_strtoul(argv[2], NULL, 16));
+	if (argc != 1)
+		return CMD_RET_USAGE;
+
+	for (i = 0; i < ARRAY_SIZE(codecs); i++)
+		err += bench(codecs[i].name, codecs[i].compress,
+			     codecs[i].uncompress, (void *)plain,
+			     strlen(plain));
+
+	/* Built-in text is too short for the inflate fast path to matter */
+	text = malloc(BENCH_TEXT_SIZE);
+	if (!text)
+		return 1;
+	bench_text(text, BENCH_TEXT_SIZE);
+	err += bench("gzip", compress_using_gzip, uncompress_using_gzip,
+		     text, BENCH_TEXT_SIZE);
+	free(text);
 
 	return err;
 }
 
 U_BOOT_CMD(
-	test_compression,	5,	1,	do_test_compression,
-	"Basic test of compressors: gzip bzip2 lzma lzo", ""
+	test_compression_bench,	3,	1,	do_test_compression_bench,
+	"Decompression speed of each codec on the same text",
+	"\n"
+	"    - all codecs on the built-in text, then gzip on 4 MiB of\n"
+	"      text generated from it\n"
+	"test_compression_bench addr len\n"
+	"    - gzip only, on memory at addr"
 );
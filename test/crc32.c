@@ -0,0 +1,86 @@
+/*
+ * Check crc32() against a bit-at-a-time reference, over every alignment
+ * and the lengths around the points where the implementation switches
+ * between its byte, word and slicing loops.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
+#include <test/errcheck.h>
+
+#define TEST_BUFFER_SIZE	(64 * 1024)
+
+static uint32_t crc32_bitwise(uint32_t crc, const uchar *buf, uint len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (k = 0; k < 8; k++)
+			crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+	}
+
+	return ~crc;
+}
+
+static int do_test_crc32(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	static const uint lens[] = { 0, 1, 3, 4, 7, 8, 9, 63, 64, 65, 71, 72,
+				     127, 128, 1000, 4095, TEST_BUFFER_SIZE };
+	uint32_t seed = 0x12345678;
+	uint off, len, split;
+	uchar *buf;
+	int ret = 0;
+	int i;
+
+	buf = malloc(TEST_BUFFER_SIZE + 8);
+	if (!buf)
+		return 1;
+	for (i = 0; i < TEST_BUFFER_SIZE + 8; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+
+	/* The check value from the CRC-32 specification */
+	errcheck(crc32(0, (const uchar *)"123456789", 9) == 0xcbf43926);
+
+	printf(" testing alignments and lengths ...\n");
+	for (off = 0; off < 8; off++) {
+		for (i = 0; i < ARRAY_SIZE(lens); i++) {
+			len = lens[i];
+			errcheck(crc32(0, buf + off, len) ==
+				 crc32_bitwise(0, buf + off, len));
+			errcheck(crc32(seed, buf + off, len) ==
+				 crc32_bitwise(seed, buf + off, len));
+			errcheck(crc32_no_comp(seed, buf + off, len) ==
+				 ~crc32_bitwise(~seed, buf + off, len));
+		}
+	}
+
+	printf(" testing chained calls ...\n");
+	len = 4096;
+	for (split = 0; split <= 200; split++) {
+		errcheck(crc32(crc32(0, buf + 1, split), buf + 1 + split,
+			       len - split) == crc32_bitwise(0, buf + 1, len));
+	}
+
+	printf(" testing crc32_wd ...\n");
+	errcheck(crc32_wd(0, buf, TEST_BUFFER_SIZE, 1000) ==
+		 crc32_bitwise(0, buf, TEST_BUFFER_SIZE));
+
+out:
+	free(buf);
+
+	return test_report("test_crc32", ret);
+}
+
+U_BOOT_CMD(
+	test_crc32,	5,	1,	do_test_crc32,
+	"Check crc32() against a bitwise reference", ""
+);
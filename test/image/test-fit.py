@@ -44,6 +44,12 @@ base_its = '''
                         compression = "none";
                         load = <0x40000>;
                         entry = <0x8>;
+                        hash@1 {
+                                algo = "sha1";
+                        };
+                        hash@2 {
+                                algo = "crc32";
+                        };
                 };
                 fdt@1 {
                         description = "snow";
@@ -52,6 +58,9 @@ base_its = '''
                         arch = "sandbox";
                         %(fdt_load)s
                         compression = "none";
+                        hash@1 {
+                                algo = "sha1";
+                        };
                         signature@1 {
                                 algo = "sha1,rsa2048";
                                 key-name-hint = "dev";
@@ -65,6 +74,9 @@ base_its = '''
                         os = "linux";
                         %(ramdisk_load)s
                         compression = "none";
+                        hash@1 {
+                                algo = "crc32";
+                        };
                 };
         };
         configurations {
@@ -91,15 +103,17 @@ base_fdt = '''
 
 # This is the U-Boot script that is run for each test. First load the fit,
 # then do the 'bootm' command, then save out memory from the places where
-# we expect 'bootm' to write things. Then quit.
+# we expect 'bootm' to write things. Then quit. The host filesystem is only
+# reachable through a bound host device, so bind one (any file will do).
 base_script = '''
-sb load host 0 %(fit_addr)x %(fit)s
+sb bind 0 %(fit)s
+sb load host 0:0 %(fit_addr)x %(fit)s
 fdt addr %(fit_addr)x
 bootm start %(fit_addr)x
 bootm loados
-sb save host 0 %(kernel_out)s %(kernel_addr)x %(kernel_size)x
-sb save host 0 %(fdt_out)s %(fdt_addr)x %(fdt_size)x
-sb save host 0 %(ramdisk_out)s %(ramdisk_addr)x %(ramdisk_size)x
+sb save host 0:0 %(kernel_out)s %(kernel_addr)x %(kernel_size)x
+sb save host 0:0 %(fdt_out)s %(fdt_addr)x %(fdt_size)x
+sb save host 0:0 %(ramdisk_out)s %(ramdisk_addr)x %(ramdisk_size)x
 reset
 '''
 
@@ -136,6 +150,30 @@ def read_file(fname):
     with open(fname, 'r') as fd:
         return fd.read()
 
+def write_file(fname, data):
+    """Write data to a file
+
+    Args:
+        fname: Filename to write
+        data: Contents to write, as a string
+    """
+    with open(fname, 'w') as fd:
+        fd.write(data)
+
+def corrupt_fit(fit, contents):
+    """Flip a bit in one of the sub-images of a FIT, in place
+
+    Args:
+        fit: Filename of the FIT
+        contents: Filename of the file making up the sub-image data
+    """
+    data = read_file(fit)
+    pos = data.find(read_file(contents))
+    if pos == -1:
+        raise ValueError("Sub-image data not found in '%s'" % fit)
+    pos += 10
+    write_file(fit, data[:pos] + chr(ord(data[pos]) ^ 1) + data[pos + 1:])
+
 def make_dtb():
     """Make a sample .dts file and compile it to a .dtb
 
@@ -272,7 +310,6 @@ def run_fit_test(mkimage, u_boot):
     """Basic sanity check of FIT loading in U-Boot
 
     TODO: Almost everything:
-       - hash algorithms - invalid hash/contents should be detected
        - signature algorithms - invalid sig/contents should be detected
        - compression
        - checking that errors are detected like:
@@ -359,6 +396,31 @@ def run_fit_test(mkimage, u_boot):
     if read_file(ramdisk) == read_file(ramdisk_out):
         fail('Ramdisk loaded but should not be', stdout)
 
+    # Every image is checked against its hashes; with CONFIG_SMP_JOBS the
+    # values come from the verify plan of the configuration
+    set_test('Hash check')
+    find_matching(stdout, 'Verifying Hash Integrity ... sha1+ crc32+ OK')
+    find_matching(stdout, 'Verifying Hash Integrity ... sha1+ OK')
+
+    # A corrupt kernel must not be loaded
+    set_test('Kernel hash mismatch')
+    corrupt_fit(fit, kernel)
+    write_file(kernel_out, '')
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', cmd)
+    find_matching(stdout, "Bad hash value for 'hash@1' hash node in "
+                  "'kernel@1' image node")
+    if read_file(kernel) == read_file(kernel_out):
+        fail('Corrupt kernel loaded', stdout)
+
+    # Nor a corrupt FDT, once the kernel has been checked
+    set_test('FDT hash mismatch')
+    fit = make_fit(mkimage, params)
+    corrupt_fit(fit, control_dtb)
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', cmd)
+    find_matching(stdout, 'Verifying Hash Integrity ... sha1+ crc32+ OK')
+    find_matching(stdout, "Bad hash value for 'hash@1' hash node in "
+                  "'fdt@1' image node")
+
     # Try a ramdisk
     set_test('Kernel + FDT + Ramdisk load')
     params['ramdisk_config'] = 'ramdisk = "ramdisk@1";'
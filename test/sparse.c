@@ -0,0 +1,173 @@
+/*
+ * Decode a small Android sparse image with every chunk type into a RAM
+ * backed device, feeding it in pieces of various sizes.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <asm/errno.h>
+#include <test/errcheck.h>
+
+#define TEST_BLK_SZ	4096	/* image block size */
+#define TEST_DEV_BLKSZ	512	/* device block size */
+#define TEST_DEV_BLKS	96
+#define TEST_START	8	/* device block the image goes to */
+#define TEST_IMG_BLKS	10
+#define TEST_IMG_SIZE	(TEST_IMG_BLKS * TEST_BLK_SZ + 256)
+
+static u8 *test_dev;
+
+static lbaint_t test_write(struct sparse_storage *info, lbaint_t blk,
+			   lbaint_t blkcnt, const void *buffer)
+{
+	memcpy(test_dev + blk * info->blksz, buffer, blkcnt * info->blksz);
+
+	return blkcnt;
+}
+
+static u8 *put_chunk(u8 *p, uint type, uint blks, uint data)
+{
+	put_unaligned_le16(type, p);
+	put_unaligned_le16(0, p + 2);
+	put_unaligned_le32(blks, p + 4);
+	put_unaligned_le32(sizeof(chunk_header_t) + data, p + 8);
+
+	return p + sizeof(chunk_header_t);
+}
+
+/*
+ * Build the image at @img and what it should leave on the device at
+ * @expect; returns the image length
+ */
+static ulong make_image(u8 *img, u8 *expect)
+{
+	u8 *p = img, *out = expect + TEST_START * TEST_DEV_BLKSZ;
+	uint32_t seed = 0x12345678;
+	int i;
+
+	put_unaligned_le32(SPARSE_HEADER_MAGIC, p);
+	put_unaligned_le16(1, p + 4);
+	put_unaligned_le16(0, p + 6);
+	put_unaligned_le16(sizeof(sparse_header_t) + 4, p + 8);
+	put_unaligned_le16(sizeof(chunk_header_t), p + 10);
+	put_unaligned_le32(TEST_BLK_SZ, p + 12);
+	put_unaligned_le32(TEST_IMG_BLKS, p + 16);
+	put_unaligned_le32(6, p + 20);
+	put_unaligned_le32(0, p + 24);
+	p += sizeof(sparse_header_t) + 4;	/* with some padding */
+
+	p = put_chunk(p, CHUNK_TYPE_RAW, 2, 2 * TEST_BLK_SZ);
+	for (i = 0; i < 2 * TEST_BLK_SZ; i++) {
+		seed = seed * 1103515245 + 12345;
+		*p++ = *out++ = seed >> 16;
+	}
+
+	p = put_chunk(p, CHUNK_TYPE_FILL, 3, 4);
+	put_unaligned_le32(0xdeadbeef, p);
+	p += 4;
+	for (i = 0; i < 3 * TEST_BLK_SZ; i += 4, out += 4)
+		put_unaligned_le32(0xdeadbeef, out);
+
+	p = put_chunk(p, CHUNK_TYPE_DONT_CARE, 2, 0);
+	out += 2 * TEST_BLK_SZ;
+
+	p = put_chunk(p, CHUNK_TYPE_CRC32, 0, 4);
+	put_unaligned_le32(0, p);
+	p += 4;
+
+	p = put_chunk(p, CHUNK_TYPE_RAW, 1, TEST_BLK_SZ);
+	for (i = 0; i < TEST_BLK_SZ; i++)
+		*p++ = *out++ = i;
+
+	p = put_chunk(p, CHUNK_TYPE_FILL, 2, 4);
+	put_unaligned_le32(0, p);
+	p += 4;
+	memset(out, '\0', 2 * TEST_BLK_SZ);
+
+	return p - img;
+}
+
+/* Decode @len bytes of @img in pieces of @split; returns the result */
+static int run_image(struct sparse_stream *s, lbaint_t size, const u8 *img,
+		     ulong len, ulong split)
+{
+	struct sparse_storage info;
+	ulong off, n;
+
+	memset(test_dev, 0x55, TEST_DEV_BLKS * TEST_DEV_BLKSZ);
+	info.blksz = TEST_DEV_BLKSZ;
+	info.start = TEST_START;
+	info.size = size;
+	info.priv = NULL;
+	info.write = test_write;
+
+	sparse_stream_start(s, &info);
+	for (off = 0; off < len; off += n) {
+		n = min(split, len - off);
+		if (sparse_stream_write(s, img + off, n))
+			break;
+	}
+
+	return sparse_stream_finish(s);
+}
+
+static int do_test_sparse(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	static const ulong splits[] = { 1, 3, 12, 28, 511, 512, 4097,
+					TEST_IMG_SIZE };
+	ulong dev_size = TEST_DEV_BLKS * TEST_DEV_BLKSZ;
+	lbaint_t room = TEST_DEV_BLKS - TEST_START;
+	lbaint_t need = TEST_IMG_BLKS * TEST_BLK_SZ / TEST_DEV_BLKSZ;
+	struct sparse_stream s;
+	u8 *img, *expect;
+	ulong len;
+	int ret = 0;
+	int i;
+
+	img = malloc(TEST_IMG_SIZE);
+	expect = malloc(dev_size);
+	test_dev = malloc(dev_size);
+	if (!img || !expect || !test_dev) {
+		ret = 1;
+		goto out;
+	}
+	memset(expect, 0x55, dev_size);
+	len = make_image(img, expect);
+
+	printf(" testing split writes ...\n");
+	for (i = 0; i < ARRAY_SIZE(splits); i++) {
+		errcheck(run_image(&s, room, img, len, splits[i]) == 0);
+		errcheck(!memcmp(test_dev, expect, dev_size));
+		errcheck(s.written == need - 16);
+		errcheck(s.skipped == 16);
+	}
+
+	printf(" testing trailing data ...\n");
+	errcheck(run_image(&s, room, img, len + 100, len + 100) == 0);
+	errcheck(!memcmp(test_dev, expect, dev_size));
+
+	printf(" testing bad images ...\n");
+	errcheck(run_image(&s, room, img, len - 1, 512) == -EINVAL);
+	errcheck(run_image(&s, need - 1, img, len, len) == -ENOSPC);
+	errcheck(run_image(&s, room, img, 20, 20) == -EINVAL);
+	img[0] ^= 1;
+	errcheck(run_image(&s, room, img, len, len) == -EINVAL);
+	errcheck(s.written == 0);
+
+out:
+	free(test_dev);
+	free(expect);
+	free(img);
+
+	return test_report("test_sparse", ret);
+}
+
+U_BOOT_CMD(
+	test_sparse,	5,	1,	do_test_sparse,
+	"Check the Android sparse image decoder", ""
+);